@@ -27,6 +27,8 @@
 #include "Task/Interface/StartUpTask.h"
 #include "Task/Interface/VideoRecognitionTask.h"
 #include "Utils/Logger.hpp"
+#include "Utils/WorkerPool.hpp"
+#include "Vision/CVParallelBackend.h"
 #ifdef ASST_DEBUG
 #include "Task/Interface/DebugTask.h"
 #endif
@@ -51,6 +53,41 @@ bool ::AsstExtAPI::set_static_option(StaticOptionKey key, const std::string& val
         OnnxSessions::get_instance().use_gpu(device_id);
         return true;
     } break;
+    case StaticOptionKey::ComputeThreads: {
+        int threads = std::stoi(value);
+        if (threads < 0) {
+            Log.error(__FUNCTION__, "| invalid compute threads:", value);
+            return false;
+        }
+        WorkerPool::get_instance().set_size(static_cast<size_t>(threads));
+        CVParallelBackend::install();
+        return true;
+    } break;
+    case StaticOptionKey::OnnxIntraOpThreads: {
+        if (!OnnxSessions::get_instance().set_intra_op_threads(std::stoi(value))) {
+            Log.error(__FUNCTION__, "| failed to set intra-op threads:", value);
+            return false;
+        }
+        return true;
+    } break;
+    case StaticOptionKey::OnnxInterOpThreads: {
+        if (!OnnxSessions::get_instance().set_inter_op_threads(std::stoi(value))) {
+            Log.error(__FUNCTION__, "| failed to set inter-op threads:", value);
+            return false;
+        }
+        return true;
+    } break;
+    case StaticOptionKey::OnnxMemoryArena: {
+        if (value != "0" && value != "1") {
+            Log.error(__FUNCTION__, "| invalid memory arena value:", value);
+            return false;
+        }
+        if (!OnnxSessions::get_instance().set_memory_arena(value == "1")) {
+            Log.error(__FUNCTION__, "| failed to set memory arena:", value);
+            return false;
+        }
+        return true;
+    } break;
     default:
         Log.error(__FUNCTION__, "| unknown key:", static_cast<int>(key));
         break;
@@ -161,6 +198,16 @@ bool asst::Assistant::set_instance_option(InstanceOptionKey key, const std::stri
             return true;
         }
         break;
+    case InstanceOptionKey::ScreencapPrefetch:
+        if (constexpr std::string_view Enable = "1"; value == Enable) {
+            m_ctrler->set_screencap_prefetch(true);
+            return true;
+        }
+        else if (constexpr std::string_view Disable = "0"; value == Disable) {
+            m_ctrler->set_screencap_prefetch(false);
+            return true;
+        }
+        break;
     default:
         break;
     }
@@ -32,6 +32,15 @@ namespace asst
         CpuOCR = 1, // use CPU to OCR, no value. It does not support switching after the resource is loaded.
         GpuOCR = 2, // use GPU to OCR, value is gpu_id int to string. It does not support switching after the resource
                     // is loaded.
+        ComputeThreads = 3, // threads shared by all recognition work in the process (MaaCore, OpenCV, ONNX Runtime),
+                            // value is int to string, "0" for auto. ONNX Runtime only picks it up for models loaded
+                            // afterwards. OpenCV keeps its own thread pool unless this option is set.
+        OnnxIntraOpThreads = 4, // intra-op threads of the process-wide ONNX Runtime thread pool, value is int to
+                                // string, "0" to follow ComputeThreads. Must be set before any model is loaded.
+        OnnxInterOpThreads = 5, // inter-op threads of the process-wide ONNX Runtime thread pool, value is int to
+                                // string, "0" to run operators sequentially. Must be set before any model is loaded.
+        OnnxMemoryArena = 6,    // whether ONNX Runtime uses a CPU memory arena, "1" (default) or "0". Disabling it
+                                // lowers memory usage but may be slower. Must be set before any model is loaded.
     };
 
     enum class InstanceOptionKey
@@ -42,6 +51,7 @@ namespace asst
         DeploymentWithPause = 3, // 自动战斗、肉鸽、保全 是否使用 暂停下干员， "0" | "1"
         AdbLiteEnabled = 4,      // 是否使用 AdbLite， "0" | "1"
         KillAdbOnExit = 5,       // 退出时是否杀掉 Adb 进程， "0" | "1"
+        ScreencapPrefetch = 6,   // 是否在分析当前帧时预先截取下一帧， "0" | "1"
     };
 
     enum class TouchMode
@@ -477,6 +487,7 @@ namespace asst
         bool full_match = false;       // 是否需要全匹配，否则搜索到子串就算匹配上了
         bool is_ascii = false;         // 是否启用字符数字模型
         bool without_det = false;      // 是否不使用检测模型
+        bool use_cache = false;        // 是否缓存识别结果，像素完全相同的图不再重复识别
         bool replace_full = false; // 匹配之后，是否将整个字符串replace（false是只替换match的部分）
         std::vector<std::pair<std::string, std::string>>
             replace_map; // 部分文字容易识别错，字符串强制replace之后，再进行匹配
@@ -497,12 +508,18 @@ namespace asst
         using ColorRange = std::pair<std::array<int, 3>, std::array<int, 3>>;
         using Range = std::variant<GrayRange, ColorRange>;
         using Ranges = std::vector<Range>;
+        static constexpr int MaxPyramidLevel = 2;
+        static constexpr int MaxPrefilter = 255;
         std::vector<std::string> templ_names; // 匹配模板图片文件名
         std::vector<double> templ_thresholds; // 模板匹配阈值
         std::vector<MatchMethod> methods;     // 匹配方法
         Ranges mask_ranges;      // 匹配掩码范围，TaskData 仅允许 array<int, 2>，但保留彩色掩码支持
         Ranges color_scales;     // 数色掩码范围
         bool color_close = true; // 数色时是否使用闭运算处理
+        bool batch_match = false; // 是否把多个模板放在一起批量匹配
+        int pyramid_level = 0;    // 由粗到细匹配时缩小的层数，0 为不使用
+        int prefilter = 0;        // 匹配前的平均颜色预筛选允许的最大差值，0 为不使用
+        bool gray_first = false;  // 是否先在灰度图上找候选位置，再用彩色图确认得分
     };
     using MatchTaskPtr = std::shared_ptr<MatchTaskInfo>;
     using MatchTaskConstPtr = std::shared_ptr<const MatchTaskInfo>;
@@ -93,6 +93,10 @@ bool asst::GeneralConfig::parse(const json::value& json)
         adb.screencap_raw_with_gzip =
             cfg_json.get("screencapRawWithGzip", base_cfg.screencap_raw_with_gzip);
         adb.screencap_raw_by_nc = cfg_json.get("screencapRawByNC", base_cfg.screencap_raw_by_nc);
+        adb.screencap_raw_by_stream =
+            cfg_json.get("screencapRawByStream", base_cfg.screencap_raw_by_stream);
+        adb.screencap_h264_stream =
+            cfg_json.get("screencapH264Stream", base_cfg.screencap_h264_stream);
         adb.nc_address = cfg_json.get("ncAddress", base_cfg.nc_address);
         adb.screencap_encode = cfg_json.get("screencapEncode", base_cfg.screencap_encode);
         adb.release = cfg_json.get("release", base_cfg.release);
@@ -74,6 +74,8 @@ struct AdbCfg
     std::string display;
     std::string screencap_raw_with_gzip;
     std::string screencap_raw_by_nc;
+    std::string screencap_raw_by_stream;
+    std::string screencap_h264_stream;
     std::string nc_address;
     std::string screencap_encode;
     std::string release;
@@ -3,8 +3,72 @@
 #include <meojson/json.hpp>
 
 #include "Utils/Logger.hpp"
+#include "Utils/StringMisc.hpp"
 
 std::string asst::OcrConfig::process_equivalence_class(const std::string& str) const
+{
+    if (m_eq_trie.size() <= 1) {
+        return str;
+    }
+
+    std::string result;
+    result.reserve(str.size());
+    for (size_t pos = 0; pos < str.size();) {
+        // 最长匹配。UTF-8 的首字节不会和后续字节相同，所以不会从一个字的中间匹配上
+        const std::string* target = nullptr;
+        size_t matched_len = 0;
+        size_t node = 0;
+        for (size_t i = pos; i < str.size(); ++i) {
+            const auto& children = m_eq_trie[node].children;
+            auto iter = ranges::find(children, str[i], &std::pair<char, size_t>::first);
+            if (iter == children.end()) {
+                break;
+            }
+            node = iter->second;
+            if (m_eq_trie[node].target) {
+                target = &*m_eq_trie[node].target;
+                matched_len = i - pos + 1;
+            }
+        }
+        if (target) {
+            result += *target;
+            pos += matched_len;
+        }
+        else {
+            result += str[pos];
+            ++pos;
+        }
+    }
+    return result;
+}
+
+std::shared_ptr<const asst::OcrConfig::RequiredList>
+    asst::OcrConfig::get_required(const std::vector<std::string>& required, const std::string& cache_key) const
+{
+    if (!cache_key.empty()) {
+        std::unique_lock<std::mutex> lock(m_required_mutex);
+        if (auto iter = m_required_cache.find(cache_key); iter != m_required_cache.end()) {
+            const auto& cached = *iter->second;
+            if (ranges::equal(cached, required, std::equal_to<> {}, &RequiredList::value_type::first)) {
+                return iter->second;
+            }
+        }
+    }
+
+    auto result = std::make_shared<RequiredList>();
+    result->reserve(required.size());
+    for (const std::string& str : required) {
+        result->emplace_back(str, process_equivalence_class(str));
+    }
+
+    if (!cache_key.empty()) {
+        std::unique_lock<std::mutex> lock(m_required_mutex);
+        m_required_cache.insert_or_assign(cache_key, result);
+    }
+    return result;
+}
+
+std::string asst::OcrConfig::process_equivalence_class_sequentially(const std::string& str) const
 {
     std::string result = str;
     for (const auto& eq_class : m_eq_classes) {
@@ -15,11 +79,59 @@ std::string asst::OcrConfig::process_equivalence_class(const std::string& str) c
     return result;
 }
 
+std::shared_ptr<const std::regex> asst::OcrConfig::get_replace_regex(const std::string& key) const
+{
+    {
+        std::unique_lock<std::mutex> lock(m_replace_regexes_mutex);
+        if (auto iter = m_replace_regexes.find(key); iter != m_replace_regexes.end()) {
+            return iter->second;
+        }
+    }
+
+    std::string pattern = key;
+    for (const auto& eq_class : m_eq_classes) {
+        if (eq_class.size() <= 1) continue;
+
+        // eq_class: [s, S] -> regex: "(?:s|S)"
+        std::string eq_classes_regex = "(?:";
+        for (const auto& elem : eq_class)
+            (eq_classes_regex += elem) += '|';
+        eq_classes_regex.pop_back();
+        eq_classes_regex += ')';
+        ranges::for_each(eq_class, [&](std::string_view elem) {
+            utils::string_replace_all_in_place(pattern, elem, eq_classes_regex);
+        });
+    }
+
+    std::shared_ptr<const std::regex> regex;
+    try {
+        regex = std::make_shared<const std::regex>(pattern);
+    }
+    catch (const std::regex_error& e) {
+        Log.error(__FUNCTION__, "| invalid regex", key, e.what());
+    }
+
+    std::unique_lock<std::mutex> lock(m_replace_regexes_mutex);
+    if (m_replace_regexes.size() >= MaxReplaceRegexCacheSize) {
+        m_replace_regexes.clear();
+    }
+    m_replace_regexes.insert_or_assign(key, regex);
+    return regex;
+}
+
 bool asst::OcrConfig::parse(const json::value& json)
 {
     LogTraceFunction;
 
     m_eq_classes.clear();
+    {
+        std::unique_lock<std::mutex> lock(m_replace_regexes_mutex);
+        m_replace_regexes.clear();
+    }
+    {
+        std::unique_lock<std::mutex> lock(m_required_mutex);
+        m_required_cache.clear();
+    }
 
     for (const json::value& eq_class : json.at("equivalence_classes").as_array()) {
         equivalence_class eq_class_tmp;
@@ -28,5 +140,34 @@ bool asst::OcrConfig::parse(const json::value& json)
         }
         m_eq_classes.emplace_back(std::move(eq_class_tmp));
     }
+    build_eq_trie();
     return true;
 }
+
+void asst::OcrConfig::build_eq_trie()
+{
+    m_eq_trie.assign(1, EqTrieNode {});
+    for (const auto& eq_class : m_eq_classes) {
+        for (const std::string& elem : eq_class) {
+            // 一个字可能在好几个等价类里，按原来逐个替换的顺序算出它最后会变成什么
+            std::string target = process_equivalence_class_sequentially(elem);
+            if (elem.empty() || target == elem) {
+                continue;
+            }
+            size_t node = 0;
+            for (char c : elem) {
+                auto& children = m_eq_trie[node].children;
+                auto iter = ranges::find(children, c, &std::pair<char, size_t>::first);
+                if (iter != children.end()) {
+                    node = iter->second;
+                    continue;
+                }
+                const size_t child = m_eq_trie.size();
+                children.emplace_back(c, child);
+                m_eq_trie.emplace_back();
+                node = child;
+            }
+            m_eq_trie[node].target = std::move(target);
+        }
+    }
+}
@@ -4,8 +4,13 @@
 
 #include "Utils/Ranges.hpp"
 #include <algorithm>
+#include <memory>
+#include <mutex>
 #include <numeric>
+#include <optional>
+#include <regex>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -16,16 +21,45 @@ namespace asst
     class OcrConfig final : public SingletonHolder<OcrConfig>, public AbstractConfig
     {
     public:
+        using RequiredList = std::vector<std::pair<std::string, std::string>>; // raw, equivalent
+
         virtual ~OcrConfig() override = default;
 
+        // 每个字换成所在等价类的第一个字，用加载时建好的字典树一遍扫完
         std::string process_equivalence_class(const std::string& str) const;
+        // 对 required 的每一项做等价类归一化。cache_key（一般是任务名）非空时缓存结果，
+        // required 有变化或重新加载后失效
+        std::shared_ptr<const RequiredList> get_required(const std::vector<std::string>& required,
+                                                         const std::string& cache_key = std::string()) const;
         auto get_eq_classes() const noexcept { return m_eq_classes; }
+        // ocrReplace 的 key 编译成的正则，等价类里的字都能匹配上。按 key 缓存，重新加载后失效
+        // key 不是合法的正则时返回 nullptr
+        std::shared_ptr<const std::regex> get_replace_regex(const std::string& key) const;
 
     protected:
+        static constexpr size_t MaxReplaceRegexCacheSize = 4096;
+
         virtual bool parse(const json::value& json) override;
 
         using equivalence_class = std::vector<std::string>;
 
+        struct EqTrieNode
+        {
+            std::vector<std::pair<char, size_t>> children;
+            std::optional<std::string> target; // 从根到这里的字符串要换成什么，不用换时为空
+        };
+
+        // 逐个等价类、逐个字替换，只在建字典树时用来算每个字最终换成什么
+        std::string process_equivalence_class_sequentially(const std::string& str) const;
+        void build_eq_trie();
+
         std::vector<equivalence_class> m_eq_classes;
+        std::vector<EqTrieNode> m_eq_trie; // 0 为根节点
+
+        mutable std::mutex m_required_mutex;
+        mutable std::unordered_map<std::string, std::shared_ptr<const RequiredList>> m_required_cache;
+
+        mutable std::mutex m_replace_regexes_mutex;
+        mutable std::unordered_map<std::string, std::shared_ptr<const std::regex>> m_replace_regexes;
     };
 } // namespace asst
@@ -1,5 +1,7 @@
 #include "OcrPack.h"
 
+#include <bit>
+#include <cstring>
 #include <filesystem>
 
 #include "Utils/NoWarningCV.h"
@@ -9,6 +11,7 @@ ASST_SUPPRESS_CV_WARNINGS_START
 #include "fastdeploy/vision/ocr/ppocr/recognizer.h"
 ASST_SUPPRESS_CV_WARNINGS_END
 
+#include "Config/OnnxSessions.h"
 #include "Utils/Demangle.hpp"
 #include "Utils/File.hpp"
 #include "Utils/Logger.hpp"
@@ -37,6 +40,9 @@ bool asst::OcrPack::load(const std::filesystem::path& path)
     LogTraceFunction;
     Log.info("load", path.lexically_relative(UserDir.get()));
 
+    std::unique_lock<std::mutex> lock(m_mutex);
+    clear_cache();
+
     using namespace asst::utils::path_literals;
     const auto det_dir = path / "det"_p;
     const auto det_model_file = det_dir / "inference.onnx"_p;
@@ -66,8 +72,18 @@ bool asst::OcrPack::load(const std::filesystem::path& path)
     return !m_det_model_path.empty() && !m_rec_model_path.empty() && !m_rec_label_path.empty();
 }
 
-asst::OcrPack::ResultsVec asst::OcrPack::recognize(const cv::Mat& image, bool without_det)
+asst::OcrPack::ResultsVec asst::OcrPack::recognize(const cv::Mat& image, bool without_det, bool use_cache)
 {
+    std::optional<CacheKey> cache_key;
+    if (use_cache) {
+        cache_key = make_cache_key(image, without_det);
+        if (auto cached = find_cache(*cache_key)) {
+            Log.trace(utils::demangle(typeid(*this).name()), *cached, "by OCR cache");
+            return std::move(*cached);
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
     if (!check_and_load()) {
         Log.error(__FUNCTION__, "check_and_load failed");
         return {};
@@ -126,10 +142,92 @@ asst::OcrPack::ResultsVec asst::OcrPack::recognize(const cv::Mat& image, bool wi
         raw_results.emplace_back(std::move(result));
     }
 
+    auto duration = std::chrono::steady_clock::now() - start_time;
+    auto costs = std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+    std::string class_type = utils::demangle(typeid(*this).name());
+    Log.trace(class_type, raw_results, without_det ? "by OCR Rec" : "by OCR Pipeline", ", cost", costs, "ms");
+    if (cache_key) {
+        insert_cache(*cache_key, raw_results, std::chrono::duration<double, std::milli>(duration).count());
+    }
+    return raw_results;
+}
+
+asst::OcrPack::ResultsVec asst::OcrPack::recognize_batch(std::span<const cv::Mat> images, bool use_cache)
+{
+    ResultsVec raw_results(images.size());
+    for (size_t i = 0; i < images.size(); ++i) {
+        raw_results[i].rect = Rect(0, 0, images[i].cols, images[i].rows);
+    }
+
+    // 缓存里有的直接用，剩下的才需要推理
+    std::vector<size_t> order;
+    std::vector<CacheKey> cache_keys(use_cache ? images.size() : 0);
+    order.reserve(images.size());
+    for (size_t i = 0; i < images.size(); ++i) {
+        if (images[i].empty()) {
+            continue;
+        }
+        if (use_cache) {
+            cache_keys[i] = make_cache_key(images[i], true);
+            if (auto cached = find_cache(cache_keys[i])) {
+                if (!cached->empty()) {
+                    raw_results[i] = std::move(cached->front());
+                }
+                continue;
+            }
+        }
+        order.emplace_back(i);
+    }
+    if (order.empty()) {
+        return raw_results;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!check_and_load()) {
+        Log.error(__FUNCTION__, "check_and_load failed");
+        return raw_results;
+    }
+
+    // 按宽高比排序，同一批里的图 padding 到差不多的宽度
+    auto ratio = [&](size_t i) { return static_cast<double>(images[i].cols) / images[i].rows; };
+    ranges::sort(order, [&](size_t lhs, size_t rhs) { return ratio(lhs) < ratio(rhs); });
+
+    auto start_time = std::chrono::steady_clock::now();
+    for (size_t begin = 0; begin < order.size(); begin += RecBatchSize) {
+        const size_t end = (std::min)(order.size(), begin + RecBatchSize);
+        auto batch_start_time = std::chrono::steady_clock::now();
+        std::vector<cv::Mat> batch;
+        batch.reserve(end - begin);
+        for (size_t k = begin; k < end; ++k) {
+            batch.emplace_back(images[order[k]]);
+        }
+
+        std::vector<std::string> texts;
+        std::vector<float> scores;
+        if (!m_rec->BatchPredict(batch, &texts, &scores) || texts.size() != batch.size() ||
+            scores.size() != batch.size()) {
+            Log.error(__FUNCTION__, "BatchPredict failed");
+            continue;
+        }
+        for (size_t k = begin; k < end; ++k) {
+            Result& result = raw_results[order[k]];
+            result.text = std::move(texts[k - begin]);
+            result.score = scores[k - begin];
+        }
+        if (use_cache) {
+            // 一批的耗时平摊到每张图上
+            auto batch_duration = std::chrono::steady_clock::now() - batch_start_time;
+            const double cost = std::chrono::duration<double, std::milli>(batch_duration).count() / (end - begin);
+            for (size_t k = begin; k < end; ++k) {
+                insert_cache(cache_keys[order[k]], { raw_results[order[k]] }, cost);
+            }
+        }
+    }
+
     auto costs =
         std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time).count();
     std::string class_type = utils::demangle(typeid(*this).name());
-    Log.trace(class_type, raw_results, without_det ? "by OCR Rec" : "by OCR Pipeline", ", cost", costs, "ms");
+    Log.trace(class_type, raw_results, "by OCR Rec batch of", order.size(), ", cost", costs, "ms");
     return raw_results;
 }
 
@@ -141,8 +239,14 @@ bool asst::OcrPack::check_and_load()
 
     LogTraceFunction;
 
+    // fastdeploy 里每个模型自己创建 Ort::Env，拿到的是进程内同一个 OrtEnv，所以要先按我们的设置创建好
+    // fastdeploy 没法关掉每个 session 自己的线程池，只能让线程数和其他模型保持一致
+    auto& onnx_sessions = OnnxSessions::get_instance();
+    onnx_sessions.env();
+
     fastdeploy::RuntimeOption option;
     option.UseOrtBackend();
+    option.SetCpuThreadNum(onnx_sessions.intra_op_threads());
     if (m_gpu_id) {
         option.UseGpu(*m_gpu_id);
     }
@@ -170,3 +274,83 @@ bool asst::OcrPack::check_and_load()
 
     return det_inited && rec_inited && ocr_inited;
 }
+
+asst::OcrPack::CacheKey asst::OcrPack::make_cache_key(const cv::Mat& image, bool without_det)
+{
+    // 只用来判断两张图的像素是不是完全一样，不需要抗碰撞，按 8 字节一组混合，和 xxHash 的做法类似
+    constexpr uint64_t Prime1 = 0x9E3779B185EBCA87ULL;
+    constexpr uint64_t Prime2 = 0xC2B2AE3D27D4EB4FULL;
+    auto round = [&](uint64_t acc, uint64_t input) { return std::rotl(acc + input * Prime2, 31) * Prime1; };
+
+    uint64_t hash = Prime1;
+    const size_t row_bytes = static_cast<size_t>(image.cols) * image.elemSize();
+    for (int y = 0; y < image.rows; ++y) {
+        const uchar* row = image.ptr<uchar>(y);
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= row_bytes; i += sizeof(uint64_t)) {
+            uint64_t word = 0;
+            std::memcpy(&word, row + i, sizeof(uint64_t));
+            hash = round(hash, word);
+        }
+        if (i < row_bytes) {
+            uint64_t word = 0;
+            std::memcpy(&word, row + i, row_bytes - i);
+            hash = round(hash, word);
+        }
+    }
+    hash ^= hash >> 33;
+    hash *= Prime2;
+    hash ^= hash >> 29;
+
+    return CacheKey {
+        .hash = hash,
+        .cols = image.cols,
+        .rows = image.rows,
+        .type = image.type(),
+        .without_det = without_det,
+    };
+}
+
+std::optional<asst::OcrPack::ResultsVec> asst::OcrPack::find_cache(const CacheKey& key)
+{
+    std::unique_lock<std::mutex> lock(m_cache_mutex);
+
+    std::optional<ResultsVec> result;
+    ++m_cache_lookups;
+    if (auto iter = m_cache_index.find(key); iter != m_cache_index.end()) {
+        m_cache_list.splice(m_cache_list.begin(), m_cache_list, iter->second);
+        ++m_cache_hits;
+        m_cache_saved += iter->second->cost;
+        result = iter->second->results;
+    }
+
+    if (m_cache_lookups % CacheLogInterval == 0) {
+        Log.info(utils::demangle(typeid(*this).name()), "cache | hit", m_cache_hits, "/", m_cache_lookups, ", rate",
+                 static_cast<double>(m_cache_hits) / m_cache_lookups, ", saved", m_cache_saved, "ms");
+    }
+    return result;
+}
+
+void asst::OcrPack::insert_cache(const CacheKey& key, const ResultsVec& results, double cost)
+{
+    std::unique_lock<std::mutex> lock(m_cache_mutex);
+
+    if (auto iter = m_cache_index.find(key); iter != m_cache_index.end()) {
+        // 两个线程同时识别了同一张图
+        m_cache_list.splice(m_cache_list.begin(), m_cache_list, iter->second);
+        return;
+    }
+    if (m_cache_list.size() >= CacheCapacity) {
+        m_cache_index.erase(m_cache_list.back().key);
+        m_cache_list.pop_back();
+    }
+    m_cache_list.emplace_front(CacheEntry { .key = key, .results = results, .cost = cost });
+    m_cache_index.emplace(key, m_cache_list.begin());
+}
+
+void asst::OcrPack::clear_cache()
+{
+    std::unique_lock<std::mutex> lock(m_cache_mutex);
+    m_cache_list.clear();
+    m_cache_index.clear();
+}
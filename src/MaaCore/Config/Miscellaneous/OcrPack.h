@@ -3,7 +3,12 @@
 #include "Common/AsstTypes.h"
 #include "Config/AbstractResource.h"
 
+#include <cstdint>
+#include <list>
+#include <mutex>
 #include <optional>
+#include <span>
+#include <unordered_map>
 #include <vector>
 
 namespace cv
@@ -42,13 +47,49 @@ namespace asst
         void use_cpu() { m_gpu_id = std::nullopt; }
         void use_gpu(int gpu_id) { m_gpu_id = gpu_id; }
 
-        ResultsVec recognize(const cv::Mat& image, bool without_det = false);
+        // use_cache 为 true 时，像素完全相同的图直接返回上次的识别结果，不再推理
+        ResultsVec recognize(const cv::Mat& image, bool without_det = false, bool use_cache = false);
+        // 多张图一起做文字识别（不检测文字位置），结果和 images 一一对应，rect 为整张图
+        // 宽高比相近的图拼成一批，每批只推理一次
+        ResultsVec recognize_batch(std::span<const cv::Mat> images, bool use_cache = false);
 
     protected:
+        static constexpr size_t RecBatchSize = 16;      // 一批最多多少张图，太多的话 padding 浪费的也多
+        static constexpr size_t CacheCapacity = 256;    // 识别结果缓存最多存多少张图的结果
+        static constexpr size_t CacheLogInterval = 100; // 每查多少次缓存输出一次命中率
+
+        struct CacheKey
+        {
+            uint64_t hash = 0;
+            int cols = 0;
+            int rows = 0;
+            int type = 0;
+            bool without_det = false;
+
+            bool operator==(const CacheKey&) const = default;
+        };
+
+        struct CacheKeyHasher
+        {
+            size_t operator()(const CacheKey& key) const noexcept { return static_cast<size_t>(key.hash); }
+        };
+
+        struct CacheEntry
+        {
+            CacheKey key;
+            ResultsVec results;
+            double cost = 0; // 识别这张图花了多少毫秒，命中时算作省下的时间
+        };
+
         OcrPack();
 
         bool check_and_load();
 
+        static CacheKey make_cache_key(const cv::Mat& image, bool without_det);
+        std::optional<ResultsVec> find_cache(const CacheKey& key);
+        void insert_cache(const CacheKey& key, const ResultsVec& results, double cost);
+        void clear_cache();
+
         std::unique_ptr<fastdeploy::vision::ocr::DBDetector> m_det;
         std::unique_ptr<fastdeploy::vision::ocr::Recognizer> m_rec;
         std::unique_ptr<fastdeploy::pipeline::PPOCRv3> m_ocr;
@@ -58,6 +99,17 @@ namespace asst
         std::filesystem::path m_rec_label_path;
 
         std::optional<int> m_gpu_id = std::nullopt;
+
+        // 模型不保证能被多个线程同时调用，识别的工作线程需要排队
+        std::mutex m_mutex;
+
+        // 识别结果的 LRU 缓存，每个模型各一份，换模型时清空。查缓存不需要等正在进行的识别
+        std::mutex m_cache_mutex;
+        std::list<CacheEntry> m_cache_list; // 最近用过的在前面
+        std::unordered_map<CacheKey, std::list<CacheEntry>::iterator, CacheKeyHasher> m_cache_index;
+        size_t m_cache_lookups = 0;
+        size_t m_cache_hits = 0;
+        double m_cache_saved = 0; // 毫秒
     };
 
     class WordOcr final : public SingletonHolder<WordOcr>, public OcrPack
@@ -1,10 +1,12 @@
 #include "OnnxSessions.h"
 
+#include <algorithm>
 #include <array>
 #include <filesystem>
 #include <string_view>
 
 #include "Utils/Logger.hpp"
+#include "Utils/WorkerPool.hpp"
 
 #if __has_include(<onnxruntime/dml_provider_factory.h>)
 #define WITH_DML
@@ -35,12 +37,67 @@ Ort::Session& asst::OnnxSessions::get(const std::string& name)
 {
     if (m_sessions.find(name) == m_sessions.end()) {
         Log.info(__FUNCTION__, "lazy load", name);
-        Ort::Session session(m_env, m_model_paths.at(name).c_str(), m_options);
+        Ort::Env& env = this->env();
+
+        // 线程都在 env 的全局线程池里，每个 session 不再各开一组
+        Ort::SessionOptions options = m_options.Clone();
+        options.DisablePerSessionThreads();
+        options.SetExecutionMode(m_inter_op_threads > 0 ? ORT_PARALLEL : ORT_SEQUENTIAL);
+        if (!m_memory_arena) {
+            options.DisableCpuMemArena();
+        }
+        Ort::Session session(env, m_model_paths.at(name).c_str(), options);
         m_sessions.emplace(name, std::move(session));
     }
     return m_sessions.at(name);
 }
 
+bool asst::OnnxSessions::set_intra_op_threads(int threads)
+{
+    std::unique_lock<std::mutex> lock(m_env_mutex);
+    if (m_env || threads < 0) return false;
+    m_intra_op_threads = threads;
+    return true;
+}
+
+bool asst::OnnxSessions::set_inter_op_threads(int threads)
+{
+    std::unique_lock<std::mutex> lock(m_env_mutex);
+    if (m_env || threads < 0) return false;
+    m_inter_op_threads = threads;
+    return true;
+}
+
+bool asst::OnnxSessions::set_memory_arena(bool enable)
+{
+    std::unique_lock<std::mutex> lock(m_env_mutex);
+    if (m_env) return false;
+    m_memory_arena = enable;
+    return true;
+}
+
+int asst::OnnxSessions::intra_op_threads() const
+{
+    if (m_intra_op_threads > 0) {
+        return m_intra_op_threads;
+    }
+    return static_cast<int>(WorkerPool::get_instance().size());
+}
+
+Ort::Env& asst::OnnxSessions::env()
+{
+    std::unique_lock<std::mutex> lock(m_env_mutex);
+    if (!m_env) {
+        Ort::ThreadingOptions threading_options;
+        threading_options.SetGlobalIntraOpNumThreads(intra_op_threads());
+        threading_options.SetGlobalInterOpNumThreads((std::max)(1, m_inter_op_threads));
+        m_env = Ort::Env(threading_options, ORT_LOGGING_LEVEL_WARNING, "MaaCore");
+        Log.info(__FUNCTION__, "| intra-op threads", intra_op_threads(), ", inter-op threads", m_inter_op_threads,
+                 ", memory arena", m_memory_arena);
+    }
+    return m_env;
+}
+
 bool asst::OnnxSessions::use_cpu()
 {
     if (m_sessions.size() != 0) return false;
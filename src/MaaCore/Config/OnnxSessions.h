@@ -2,6 +2,7 @@
 
 #include "AbstractResource.h"
 
+#include <mutex>
 #include <unordered_map>
 
 #if __has_include(<onnxruntime_cxx_api.h>)
@@ -24,8 +25,27 @@ namespace asst
         bool use_cpu();
         bool use_gpu(int device_id);
 
+        // 以下设置需要在第一次加载模型（包括 OCR 的模型）之前调用，之后调用会返回 false
+        // 0 为跟随 WorkerPool 的线程数
+        bool set_intra_op_threads(int threads);
+        // 0 为不开 inter-op 线程，算子按顺序执行
+        bool set_inter_op_threads(int threads);
+        bool set_memory_arena(bool enable);
+
+        int intra_op_threads() const;
+        bool memory_arena() const noexcept { return m_memory_arena; }
+
+        // 进程内共用的 Ort::Env，所有模型共用一组全局的 intra/inter-op 线程池
+        // ORT 一个进程只有一个 OrtEnv，之后谁再创建 Ort::Env 拿到的都是这一个，所以要在加载任何模型之前调用
+        Ort::Env& env();
+
     private:
-        Ort::Env m_env;
+        std::mutex m_env_mutex;
+        Ort::Env m_env { nullptr };
+        int m_intra_op_threads = 0;
+        int m_inter_op_threads = 0;
+        bool m_memory_arena = true;
+
         Ort::SessionOptions m_options;
         std::unordered_map<std::string, Ort::Session> m_sessions;
         std::unordered_map<std::string, std::filesystem::path> m_model_paths;
@@ -635,6 +635,39 @@ asst::TaskPtr asst::TaskData::generate_match_task_info(std::string_view name, co
         "colorWithClose",
         match_task_info_ptr->color_close,
         default_ptr->color_close);
+    utils::get_and_check_value_or(
+        name,
+        task_json,
+        "batchMatch",
+        match_task_info_ptr->batch_match,
+        default_ptr->batch_match);
+    utils::get_and_check_value_or(
+        name,
+        task_json,
+        "pyramidLevel",
+        match_task_info_ptr->pyramid_level,
+        default_ptr->pyramid_level);
+    if (match_task_info_ptr->pyramid_level < 0 ||
+        match_task_info_ptr->pyramid_level > MatchTaskInfo::MaxPyramidLevel) {
+        Log.error("Invalid pyramidLevel in task", name, ", should be in [0,", MatchTaskInfo::MaxPyramidLevel, "]");
+        return nullptr;
+    }
+    utils::get_and_check_value_or(
+        name,
+        task_json,
+        "prefilter",
+        match_task_info_ptr->prefilter,
+        default_ptr->prefilter);
+    if (match_task_info_ptr->prefilter < 0 || match_task_info_ptr->prefilter > MatchTaskInfo::MaxPrefilter) {
+        Log.error("Invalid prefilter in task", name, ", should be in [0,", MatchTaskInfo::MaxPrefilter, "]");
+        return nullptr;
+    }
+    utils::get_and_check_value_or(
+        name,
+        task_json,
+        "grayFirst",
+        match_task_info_ptr->gray_first,
+        default_ptr->gray_first);
 
     return match_task_info_ptr;
 }
@@ -658,6 +691,7 @@ asst::TaskPtr asst::TaskData::generate_ocr_task_info(std::string_view name, cons
     utils::get_and_check_value_or(name, task_json, "fullMatch", ocr_task_info_ptr->full_match, default_ptr->full_match);
     utils::get_and_check_value_or(name, task_json, "isAscii", ocr_task_info_ptr->is_ascii, default_ptr->is_ascii);
     utils::get_and_check_value_or(name, task_json, "withoutDet", ocr_task_info_ptr->without_det, default_ptr->without_det);
+    utils::get_and_check_value_or(name, task_json, "ocrCache", ocr_task_info_ptr->use_cache, default_ptr->use_cache);
     utils::get_and_check_value_or(name, task_json, "replaceFull", ocr_task_info_ptr->replace_full, default_ptr->replace_full);
     utils::get_and_check_value_or(name, task_json, "ocrReplace", ocr_task_info_ptr->replace_map, default_ptr->replace_map);
     return ocr_task_info_ptr;
@@ -814,6 +848,10 @@ asst::MatchTaskConstPtr asst::TaskData::_default_match_task_info()
     match_task_info_ptr->mask_ranges = {};
     match_task_info_ptr->color_scales = {};
     match_task_info_ptr->color_close = true;
+    match_task_info_ptr->batch_match = false;
+    match_task_info_ptr->pyramid_level = 0;
+    match_task_info_ptr->prefilter = 0;
+    match_task_info_ptr->gray_first = false;
 
     return match_task_info_ptr;
 }
@@ -825,6 +863,7 @@ asst::OcrTaskConstPtr asst::TaskData::_default_ocr_task_info()
     ocr_task_info_ptr->is_ascii = false;
     ocr_task_info_ptr->without_det = false;
     ocr_task_info_ptr->replace_full = false;
+    ocr_task_info_ptr->use_cache = false;
 
     return ocr_task_info_ptr;
 }
@@ -863,8 +902,9 @@ bool asst::TaskData::syntax_check(std::string_view task_name, const json::value&
               "specialParams", "sub",           "subErrorIgnored",
 
               // specific
-              "cache",         "colorScales",   "colorWithClose",  "maskRange",      "method",
-              "rectMove",      "roi",           "specialParams",   "templThreshold", "template",
+              "batchMatch",    "cache",         "colorScales",     "colorWithClose", "grayFirst",
+              "maskRange",     "method",        "prefilter",       "pyramidLevel",   "rectMove",
+              "roi",           "specialParams", "templThreshold",  "template",
           } },
         { AlgorithmType::OcrDetect,
           {
@@ -874,8 +914,8 @@ bool asst::TaskData::syntax_check(std::string_view task_name, const json::value&
               "specialParams", "sub",         "subErrorIgnored",
 
               // specific
-              "cache",         "fullMatch",   "isAscii",         "ocrReplace",   "rectMove",
-              "replaceFull",   "roi",         "text",            "withoutDet",
+              "cache",         "fullMatch",   "isAscii",         "ocrCache",     "ocrReplace",
+              "rectMove",      "replaceFull", "roi",             "text",         "withoutDet",
           } },
         { AlgorithmType::JustReturn,
           {
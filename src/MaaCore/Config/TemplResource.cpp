@@ -30,6 +30,7 @@ bool asst::TemplResource::load(const std::filesystem::path& path)
         if (std::filesystem::exists(filepath)) {
             if (auto path_iter = m_templ_paths.find(name);
                 path_iter == m_templ_paths.end() || path_iter->second != filepath) {
+                std::unique_lock<std::mutex> lock(m_templs_mutex);
                 m_templs.erase(name);
                 m_templ_paths.insert_or_assign(name, filepath);
             }
@@ -56,6 +57,7 @@ bool asst::TemplResource::load(const std::filesystem::path& path)
 
 const cv::Mat& asst::TemplResource::get_templ(const std::string& name)
 {
+    std::unique_lock<std::mutex> lock(m_templs_mutex);
     if (m_templs.find(name) == m_templs.cend()) {
         // Log.info(__FUNCTION__, "lazy load", name);
 
@@ -2,6 +2,7 @@
 
 #include "AbstractResource.h"
 
+#include <mutex>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -24,5 +25,6 @@ namespace asst
         std::unordered_set<std::string> m_load_required;
         std::unordered_map<std::string, cv::Mat> m_templs;
         std::unordered_map<std::string, std::filesystem::path> m_templ_paths;
+        std::mutex m_templs_mutex; // get_templ 会在识别的工作线程上懒加载
     };
 }
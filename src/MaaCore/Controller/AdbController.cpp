@@ -5,6 +5,8 @@
 #include "Utils/NoWarningCV.h"
 #include <cstdint>
 #include <numeric>
+#include <string_view>
+#include <thread>
 
 #ifdef _MSC_VER
 #pragma warning(push)
@@ -17,6 +19,7 @@
 
 #include "Common/AsstTypes.h"
 #include "Config/GeneralConfig.h"
+#include "Gesture.h"
 #include "Utils/Logger.hpp"
 #include "Utils/Platform.hpp"
 #include "Utils/StringMisc.hpp"
@@ -118,15 +121,30 @@ std::optional<std::string> asst::AdbController::call_command(
     int64_t timeout,
     bool allow_reconnect,
     bool recv_by_socket)
+{
+    RecvBuffer output;
+    if (!call_command(output, cmd, timeout, allow_reconnect, recv_by_socket)) {
+        return std::nullopt;
+    }
+    return std::string(output.view());
+}
+
+bool asst::AdbController::call_command(
+    RecvBuffer& output,
+    const std::string& cmd,
+    int64_t timeout,
+    bool allow_reconnect,
+    bool recv_by_socket)
 {
     using namespace std::chrono_literals;
     using namespace std::chrono;
     // LogTraceScope(std::string(__FUNCTION__) + " | `" + cmd + "`");
 
-    std::string pipe_data;
-    std::string sock_data;
-    asst::platform::single_page_buffer<char> pipe_buffer;
-    asst::platform::single_page_buffer<char> sock_buffer;
+    // 走 socket 时 stdout 只用来打日志
+    RecvBuffer discarded;
+    RecvBuffer& pipe_data = recv_by_socket ? discarded : output;
+    RecvBuffer& sock_data = recv_by_socket ? output : discarded;
+    output.clear();
 
     auto start_time = steady_clock::now();
     std::unique_lock<std::mutex> callcmd_lock(m_callcmd_mutex);
@@ -138,7 +156,7 @@ std::optional<std::string> asst::AdbController::call_command(
 
     if (!exit_res) {
         Log.warn("Call `", cmd, "` failed");
-        return std::nullopt;
+        return false;
     }
     const int exit_ret = exit_res.value();
 
@@ -158,26 +176,31 @@ std::optional<std::string> asst::AdbController::call_command(
         sock_data.size());
     if (!pipe_data.empty() && pipe_data.size() < 4096) {
         m_pipe_data_size = pipe_data.size();
-        Log.trace("stdout output:", Logger::separator::newline, pipe_data);
+        Log.trace("stdout output:", Logger::separator::newline, pipe_data.view());
     }
     if (recv_by_socket && !sock_data.empty() && sock_data.size() < 4096) {
-        Log.trace("socket output:", Logger::separator::newline, sock_data);
+        Log.trace("socket output:", Logger::separator::newline, sock_data.view());
     }
     // 直接 return，避免走到下面的 else if 里的 m_inited = false) 关闭 adb 连接，
     // 导致停止后再开始任务还需要重连一次
     if (need_exit()) {
-        return std::nullopt;
+        return false;
     }
 
     if (!exit_ret) {
-        return recv_by_socket ? sock_data : pipe_data;
+        return true;
     }
     else if (inited() && allow_reconnect) {
         // 之前可以运行，突然运行不了了，这种情况多半是 adb 炸了。所以重新连接一下
-        return reconnect(cmd, timeout, recv_by_socket);
+        auto reconnect_ret = reconnect(cmd, timeout, recv_by_socket);
+        if (!reconnect_ret) {
+            return false;
+        }
+        output.assign(reconnect_ret.value());
+        return true;
     }
 
-    return std::nullopt;
+    return false;
 }
 
 size_t asst::AdbController::get_pipe_data_size() const noexcept
@@ -227,6 +250,8 @@ std::optional<unsigned short> asst::AdbController::init_socket(const std::string
 void asst::AdbController::clear_info() noexcept
 {
     m_inited = false;
+    release_screencap_stream();
+    m_h264_stream.stop();
     m_adb = decltype(m_adb)();
     m_uuid.clear();
     m_width = 0;
@@ -331,6 +356,46 @@ bool asst::AdbController::swipe(
     return ret;
 }
 
+bool asst::AdbController::gesture(const Gesture& gesture)
+{
+    using namespace std::chrono;
+
+    // adb input 没法逐点控制，只能把每一段按下到抬起拆成一次 click 或 swipe，段与段之间在本机计时
+    const auto start_time = steady_clock::now();
+    const Gesture::Step* stroke_begin = nullptr;
+    for (const auto& step : gesture.steps()) {
+        if (step.event.pointerId != 0) {
+            Log.error("adb does not support multi-touch gesture");
+            return false;
+        }
+        switch (step.event.type) {
+        case InputEvent::Type::TOUCH_DOWN:
+            std::this_thread::sleep_until(start_time + milliseconds(step.time));
+            stroke_begin = &step;
+            break;
+        case InputEvent::Type::TOUCH_MOVE:
+            break;
+        case InputEvent::Type::TOUCH_UP: {
+            if (!stroke_begin) {
+                break;
+            }
+            const Point& p1 = stroke_begin->event.point;
+            const Point& p2 = step.event.point;
+            bool ret = p1 == p2 ? click(p1) : swipe(p1, p2, step.time - stroke_begin->time);
+            if (!ret) {
+                return false;
+            }
+            stroke_begin = nullptr;
+        } break;
+        default:
+            Log.error("adb does not support input event in gesture");
+            return false;
+        }
+    }
+    std::this_thread::sleep_until(start_time + milliseconds(gesture.duration()));
+    return true;
+}
+
 bool asst::AdbController::press_esc()
 {
     LogTraceFunction;
@@ -345,6 +410,8 @@ std::pair<int, int> asst::AdbController::get_screen_res() const noexcept
 
 void asst::AdbController::release()
 {
+    release_screencap_stream();
+    m_h264_stream.stop();
     close_socket();
 
     if (m_kill_adb_on_exit && !m_adb.release.empty()) {
@@ -357,28 +424,26 @@ const std::string& asst::AdbController::get_uuid() const
     return m_uuid;
 }
 
-bool asst::AdbController::convert_lf(std::string& data)
+// 就地转换 [data, data + size) 中的 CRLF，返回转换后的长度，没找到 "\r\n" 时返回 0
+static size_t convert_lf_in_place(char* data, size_t size)
 {
-    if (data.empty() || data.size() < 2) {
-        return false;
+    if (size < 2) {
+        return 0;
     }
-    auto pred = [](const std::string::iterator& cur) -> bool {
+    auto pred = [](const char* cur) -> bool {
         return *cur == '\r' && *(cur + 1) == '\n';
     };
     // find the first of "\r\n"
-    auto first_iter = data.end();
-    for (auto iter = data.begin(); iter != data.end() - 1; ++iter) {
-        if (pred(iter)) {
-            first_iter = iter;
-            break;
-        }
+    char* const end_r1_iter = data + size - 1;
+    char* first_iter = data;
+    while (first_iter != end_r1_iter && !pred(first_iter)) {
+        ++first_iter;
     }
-    if (first_iter == data.end()) {
-        return false;
+    if (first_iter == end_r1_iter) {
+        return 0;
     }
     // move forward all non-crlf elements
-    auto end_r1_iter = data.end() - 1;
-    auto next_iter = first_iter;
+    char* next_iter = first_iter;
     while (++first_iter != end_r1_iter) {
         if (!pred(first_iter)) {
             *next_iter = *first_iter;
@@ -387,14 +452,33 @@ bool asst::AdbController::convert_lf(std::string& data)
     }
     *next_iter = *end_r1_iter;
     ++next_iter;
-    data.erase(next_iter, data.end());
+    return static_cast<size_t>(next_iter - data);
+}
+
+bool asst::AdbController::convert_lf(std::string& data)
+{
+    size_t size = convert_lf_in_place(data.data(), data.size());
+    if (size == 0) {
+        return false;
+    }
+    data.resize(size);
+    return true;
+}
+
+bool asst::AdbController::convert_lf(RecvBuffer& data)
+{
+    size_t size = convert_lf_in_place(data.data(), data.size());
+    if (size == 0) {
+        return false;
+    }
+    data.truncate(size);
     return true;
 }
 
 bool asst::AdbController::screencap(cv::Mat& image_payload, bool allow_reconnect)
 {
     using namespace std::chrono;
-    DecodeFunc decode_raw = [&](const std::string& data) -> bool {
+    DecodeFunc decode_raw = [&](std::string_view data) -> bool {
         if (data.size() < 8) {
             return false;
         }
@@ -423,8 +507,7 @@ bool asst::AdbController::screencap(cv::Mat& image_payload, bool allow_reconnect
         }
         const size_t header_size = data.size() - std_size; // 12 or 16. ref:
         // https://android.googlesource.com/platform/frameworks/base/+/26a2b97dbe48ee45e9ae70110714048f2f360f97%5E%21/cmds/screencap/screencap.cpp
-        auto img_data_beg = data.cbegin() + header_size;
-        cv::Mat temp(m_height, m_width, CV_8UC4, const_cast<char*>(&*img_data_beg));
+        cv::Mat temp(m_height, m_width, CV_8UC4, const_cast<char*>(data.data() + header_size));
         if (temp.empty()) {
             return false;
         }
@@ -432,17 +515,17 @@ bool asst::AdbController::screencap(cv::Mat& image_payload, bool allow_reconnect
         if (br[3] != 255) { // only check alpha
             return false;
         }
-        cv::cvtColor(temp, temp, cv::COLOR_RGBA2BGR);
-        image_payload = temp;
+        // 直接转换到 image_payload 里，尺寸不变时复用上一帧的内存，不再经过临时 Mat
+        cv::cvtColor(temp, image_payload, cv::COLOR_RGBA2BGR);
         return true;
     };
 
-    DecodeFunc decode_raw_with_gzip = [&](const std::string& data) -> bool {
+    DecodeFunc decode_raw_with_gzip = [&](std::string_view data) -> bool {
         const std::string raw_data = gzip::decompress(data.data(), data.size());
         return decode_raw(raw_data);
     };
 
-    DecodeFunc decode_encode = [&](const std::string& data) -> bool {
+    DecodeFunc decode_encode = [&](std::string_view data) -> bool {
         cv::Mat temp = cv::imdecode({ data.data(), int(data.size()) }, cv::IMREAD_COLOR);
         if (temp.empty()) {
             return false;
@@ -472,6 +555,49 @@ bool asst::AdbController::screencap(cv::Mat& image_payload, bool allow_reconnect
         }
         clear_lf_info();
 
+        // 先把常驻 shell 拉起来再计时，比较的是稳定后每一帧的耗时
+        if (open_screencap_stream()) {
+            start_time = high_resolution_clock::now();
+            if (screencap_by_stream(decode_raw, allow_reconnect, 5000)) {
+                auto duration =
+                    duration_cast<milliseconds>(high_resolution_clock::now() - start_time);
+                if (duration < min_cost) {
+                    m_adb.screencap_method = AdbProperty::ScreencapMethod::RawByStream;
+                    m_inited = true;
+                    min_cost = duration;
+                }
+                Log.info("RawByStream cost", duration.count(), "ms");
+            }
+            else {
+                Log.info("RawByStream is not supported");
+            }
+        }
+        else {
+            Log.info("RawByStream is not supported");
+        }
+        clear_lf_info();
+
+        // 同理，等第一帧解出来之后再计时，之后每一帧都只是从本机内存里取
+        if (open_h264_stream()) {
+            start_time = high_resolution_clock::now();
+            if (screencap_by_h264_stream(image_payload)) {
+                auto duration =
+                    duration_cast<milliseconds>(high_resolution_clock::now() - start_time);
+                if (duration < min_cost) {
+                    m_adb.screencap_method = AdbProperty::ScreencapMethod::H264Stream;
+                    m_inited = true;
+                    min_cost = duration;
+                }
+                Log.info("H264Stream cost", duration.count(), "ms");
+            }
+            else {
+                Log.info("H264Stream is not supported");
+            }
+        }
+        else {
+            Log.info("H264Stream is not supported");
+        }
+
         start_time = high_resolution_clock::now();
         if (screencap(m_adb.screencap_raw_with_gzip, decode_raw_with_gzip, allow_reconnect)) {
             auto duration = duration_cast<milliseconds>(high_resolution_clock::now() - start_time);
@@ -523,6 +649,8 @@ bool asst::AdbController::screencap(cv::Mat& image_payload, bool allow_reconnect
         static const std::unordered_map<AdbProperty::ScreencapMethod, std::string> MethodName = {
             { AdbProperty::ScreencapMethod::UnknownYet, "UnknownYet" },
             { AdbProperty::ScreencapMethod::RawByNc, "RawByNc" },
+            { AdbProperty::ScreencapMethod::RawByStream, "RawByStream" },
+            { AdbProperty::ScreencapMethod::H264Stream, "H264Stream" },
             { AdbProperty::ScreencapMethod::RawWithGzip, "RawWithGzip" },
             { AdbProperty::ScreencapMethod::Encode, "Encode" },
 #if ASST_WITH_EMULATOR_EXTRAS
@@ -535,6 +663,14 @@ bool asst::AdbController::screencap(cv::Mat& image_payload, bool allow_reconnect
             ", cost:",
             min_cost.count(),
             "ms");
+        if (m_adb.screencap_method != AdbProperty::ScreencapMethod::RawByStream) {
+            // 没选中的话就别让设备上一直挂着一个 shell 了
+            release_screencap_stream();
+        }
+        if (m_adb.screencap_method != AdbProperty::ScreencapMethod::H264Stream) {
+            // 解码线程也挺占 CPU 的
+            m_h264_stream.stop();
+        }
         if (m_adb.screencap_method != AdbProperty::ScreencapMethod::UnknownYet) {
             json::value info = json::object {
                 { "uuid", m_uuid },
@@ -557,6 +693,12 @@ bool asst::AdbController::screencap(cv::Mat& image_payload, bool allow_reconnect
         case AdbProperty::ScreencapMethod::RawByNc:
             screencap_ret = screencap(m_adb.screencap_raw_by_nc, decode_raw, allow_reconnect, true);
             break;
+        case AdbProperty::ScreencapMethod::RawByStream:
+            screencap_ret = screencap_by_stream(decode_raw, allow_reconnect);
+            break;
+        case AdbProperty::ScreencapMethod::H264Stream:
+            screencap_ret = screencap_by_h264_stream(image_payload);
+            break;
         case AdbProperty::ScreencapMethod::RawWithGzip:
             screencap_ret =
                 screencap(m_adb.screencap_raw_with_gzip, decode_raw_with_gzip, allow_reconnect);
@@ -633,14 +775,203 @@ bool asst::AdbController::screencap(
     if ((!m_support_socket || !m_server_started) && by_socket) [[unlikely]] {
         return false;
     }
-    auto ret = call_command(cmd, timeout, allow_reconnect, by_socket);
+    RecvBuffer& data = acquire_screencap_buffer();
+    if (!call_command(data, cmd, timeout, allow_reconnect, by_socket) || data.empty()) [[unlikely]] {
+        Log.warn("data is empty!");
+        return false;
+    }
+    return decode_screencap_data(data, decode_func);
+}
 
-    if (!ret || ret.value().empty()) [[unlikely]] {
+asst::RecvBuffer& asst::AdbController::acquire_screencap_buffer()
+{
+    // 截图由 Controller 串行调用，缓冲区每帧复用，不会每次重新分配、清零
+    // 按一整帧原始数据（RGBA + 最多 16 字节的头）预留，多留一页，读到结尾时也不用扩容
+    m_screencap_buffer.clear();
+    m_screencap_buffer.reserve(4ULL * m_width * m_height + 16 + platform::page_size);
+    return m_screencap_buffer;
+}
+
+bool asst::AdbController::screencap_by_stream(
+    const DecodeFunc& decode_func,
+    bool allow_reconnect,
+    int timeout)
+{
+    using namespace std::chrono;
+
+    // 每帧之后追加一个结束标记，用来在持续的字节流里切分出完整的一帧
+    static constexpr std::string_view EndMarker = "__MAA_SCREENCAP_END__";
+    static const std::string request = "screencap; echo " + std::string(EndMarker) + "\n";
+
+    auto strip_end_marker = [](RecvBuffer& data) -> bool {
+        std::string_view view = data.view();
+        if (view.empty() || view.back() != '\n') {
+            return false;
+        }
+        size_t end = view.size() - 1;
+        if (end > 0 && view[end - 1] == '\r') {
+            --end;
+        }
+        if (end < EndMarker.size() || view.substr(end - EndMarker.size(), EndMarker.size()) != EndMarker) {
+            return false;
+        }
+        data.truncate(end - EndMarker.size());
+        return true;
+    };
+
+    RecvBuffer& data = acquire_screencap_buffer();
+    auto recv_frame = [&]() -> bool {
+        if (!m_screencap_stream && !open_screencap_stream()) {
+            return false;
+        }
+        if (!m_screencap_stream->write(request)) {
+            Log.error("Failed to write to screencap stream");
+            return false;
+        }
+
+        data.clear();
+        const auto start_time = steady_clock::now();
+        while (!strip_end_marker(data)) {
+            if (need_exit()) {
+                return false;
+            }
+            if (duration_cast<milliseconds>(steady_clock::now() - start_time).count() > timeout) {
+                Log.error("screencap stream timeout, received size:", data.size());
+                return false;
+            }
+            std::string chunk = m_screencap_stream->read(1);
+            if (chunk.empty()) {
+                std::this_thread::yield();
+                continue;
+            }
+            data.append(chunk);
+        }
+        return true;
+    };
+
+    auto start_time = steady_clock::now();
+    std::unique_lock<std::mutex> callcmd_lock(m_callcmd_mutex);
+    bool received = recv_frame();
+    if (!received && allow_reconnect && !need_exit()) {
+        Log.warn("screencap stream broken, try to reopen it");
+        release_screencap_stream();
+        received = recv_frame();
+    }
+    callcmd_lock.unlock();
+
+    if (!received) {
+        // 流里可能残留了半帧数据，直接丢掉整个会话，下次重新打开
+        release_screencap_stream();
+        return false;
+    }
+    m_last_command_duration = duration_cast<milliseconds>(steady_clock::now() - start_time).count();
+
+    if (data.empty()) [[unlikely]] {
         Log.warn("data is empty!");
         return false;
     }
-    auto& data = ret.value();
+    return decode_screencap_data(data, decode_func);
+}
+
+bool asst::AdbController::open_screencap_stream()
+{
+    LogTraceFunction;
 
+    if (m_screencap_stream) {
+        return true;
+    }
+    if (m_adb.screencap_raw_by_stream.empty()) {
+        return false;
+    }
+    m_screencap_stream = m_platform_io->interactive_shell(m_adb.screencap_raw_by_stream);
+    if (!m_screencap_stream) {
+        Log.error("unable to open screencap stream");
+        return false;
+    }
+    return true;
+}
+
+void asst::AdbController::release_screencap_stream() noexcept
+{
+    m_screencap_stream.reset();
+}
+
+bool asst::AdbController::screencap_by_h264_stream(cv::Mat& image_payload)
+{
+    using namespace std::chrono;
+
+    // 设备上的 screenrecord 到了时长上限会自己重启，流断了一般是 adb 断了，重新拉起来
+    if (!m_h264_stream.running()) {
+        Log.warn("h264 stream broken, try to reopen it");
+        if (need_exit() || !open_h264_stream()) {
+            return false;
+        }
+    }
+
+    // 操作之前解出的帧不能用，等操作之后的画面解出来。screenrecord 只在画面变化时才出帧，
+    // 等不到说明操作没有改变画面，这时最新的一帧就是当前的画面
+    // 每次操作只等一次，之后画面一直不变的话直接用最新的一帧，不然每次截图都要等满超时
+    auto start_time = steady_clock::now();
+    const auto not_before = m_last_action_time.load();
+    const auto wait_timeout =
+        m_fresh_frame_waited.exchange(not_before) == not_before ? milliseconds(0) : H264FreshFrameTimeout;
+    if (!m_h264_stream.get_frame(image_payload, wait_timeout, not_before)
+        && !m_h264_stream.get_frame(image_payload, milliseconds(0))) {
+        Log.error("unable to get frame from h264 stream");
+        m_h264_stream.stop();
+        return false;
+    }
+    m_last_command_duration = duration_cast<milliseconds>(steady_clock::now() - start_time).count();
+
+    if (image_payload.cols != m_width || image_payload.rows != m_height) {
+        Log.error(
+            "Size from h264 stream",
+            image_payload.cols,
+            image_payload.rows,
+            "does not match the size of screen",
+            m_width,
+            m_height);
+        return false;
+    }
+    return true;
+}
+
+void asst::AdbController::on_action_finished(std::chrono::steady_clock::time_point time) noexcept
+{
+    m_last_action_time = time;
+}
+
+bool asst::AdbController::open_h264_stream()
+{
+    LogTraceFunction;
+
+    if (m_h264_stream.running()) {
+        return true;
+    }
+    if (m_adb.screencap_h264_stream.empty()) {
+        return false;
+    }
+    auto handler = m_platform_io->interactive_shell(m_adb.screencap_h264_stream);
+    if (!handler) {
+        Log.error("unable to open h264 stream");
+        return false;
+    }
+    if (!m_h264_stream.start(std::move(handler))) {
+        return false;
+    }
+
+    // 等 screenrecord 启动、编码器出第一个关键帧并解出来，拿不到说明设备不支持 screenrecord 或者本机没法解码
+    cv::Mat image;
+    if (!m_h264_stream.get_frame(image, std::chrono::milliseconds(5000))) {
+        Log.error("no frame decoded from h264 stream");
+        m_h264_stream.stop();
+        return false;
+    }
+    return true;
+}
+
+bool asst::AdbController::decode_screencap_data(RecvBuffer& data, const DecodeFunc& decode_func)
+{
     bool tried_conversion = false;
     if (m_adb.screencap_end_of_line == AdbProperty::ScreencapEndOfLine::CRLF) {
         tried_conversion = true;
@@ -650,7 +981,7 @@ bool asst::AdbController::screencap(
         }
     }
 
-    if (decode_func(data)) [[likely]] {
+    if (decode_func(data.view())) [[likely]] {
         if (m_adb.screencap_end_of_line == AdbProperty::ScreencapEndOfLine::UnknownYet)
             [[unlikely]] {
             Log.info("screencap_end_of_line is LF");
@@ -670,7 +1001,7 @@ bool asst::AdbController::screencap(
             Log.error("no `\\r\\n` found, skip retry decode");
             return false;
         }
-        if (!decode_func(data)) {
+        if (!decode_func(data.view())) {
             Log.error("convert lf and retry decode failed!");
             return false;
         }
@@ -910,6 +1241,8 @@ bool asst::AdbController::connect(
     m_adb.click = cmd_replace(adb_cfg.click);
     m_adb.swipe = cmd_replace(adb_cfg.swipe);
     m_adb.press_esc = cmd_replace(adb_cfg.press_esc);
+    m_adb.screencap_raw_by_stream = cmd_replace(adb_cfg.screencap_raw_by_stream);
+    m_adb.screencap_h264_stream = cmd_replace(adb_cfg.screencap_h264_stream);
     m_adb.screencap_raw_with_gzip = cmd_replace(adb_cfg.screencap_raw_with_gzip);
     m_adb.screencap_encode = cmd_replace(adb_cfg.screencap_encode);
     m_adb.start = cmd_replace(adb_cfg.start);
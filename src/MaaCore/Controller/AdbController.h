@@ -4,6 +4,8 @@
 
 #include "ControllerAPI.h"
 
+#include <atomic>
+#include <chrono>
 #include <deque>
 #include <random>
 
@@ -13,6 +15,7 @@
 #include "Config/GeneralConfig.h"
 #include "InstHelper.h"
 #include "MumuExtras.h"
+#include "ScreenrecordStream.h"
 
 namespace asst
 {
@@ -57,6 +60,8 @@ public:
         double slope_out = 1,
         bool with_pause = false) override;
 
+    virtual bool gesture(const Gesture& gesture) override;
+
     virtual bool inject_input_event([[maybe_unused]] const InputEvent& event) override
     {
         return false;
@@ -75,13 +80,24 @@ public:
     AdbController& operator=(AdbController&&) = delete;
 
     virtual void back_to_home() noexcept override;
+    virtual void on_action_finished(std::chrono::steady_clock::time_point time) noexcept override;
 
 protected:
+    // 操作之后最多等这么久的新画面，超过了说明画面没变
+    static constexpr std::chrono::milliseconds H264FreshFrameTimeout { 500 };
+
     std::optional<std::string> call_command(
         const std::string& cmd,
         int64_t timeout = 20000,
         bool allow_reconnect = true,
         bool recv_by_socket = false);
+    // 输出直接写入 output，原有内容清掉、容量保留，用于复用预留好容量的截图缓冲区
+    bool call_command(
+        RecvBuffer& output,
+        const std::string& cmd,
+        int64_t timeout,
+        bool allow_reconnect,
+        bool recv_by_socket);
 
     virtual std::optional<std::string>
         reconnect(const std::string& cmd, int64_t timeout, bool recv_by_socket);
@@ -91,13 +107,23 @@ protected:
     void close_socket() noexcept;
     std::optional<unsigned short> init_socket(const std::string& local_address);
 
-    using DecodeFunc = std::function<bool(const std::string&)>;
+    using DecodeFunc = std::function<bool(std::string_view)>;
     bool screencap(
         const std::string& cmd,
         const DecodeFunc& decode_func,
         bool allow_reconnect = false,
         bool by_socket = false,
         int max_timeout = 20000);
+    bool screencap_by_stream(
+        const DecodeFunc& decode_func,
+        bool allow_reconnect = false,
+        int timeout = 20000);
+    bool decode_screencap_data(RecvBuffer& data, const DecodeFunc& decode_func);
+    bool open_screencap_stream();
+    RecvBuffer& acquire_screencap_buffer();
+    void release_screencap_stream() noexcept;
+    bool screencap_by_h264_stream(cv::Mat& image_payload);
+    bool open_h264_stream();
     void clear_lf_info();
 
     virtual void clear_info() noexcept;
@@ -107,6 +133,7 @@ protected:
     // 转换 data 中的 CRLF 为 LF：有些模拟器自带的 adb，exec-out 输出的 \n 会被替换成 \r\n，
     // 导致解码错误，所以这里转一下回来（点名批评 mumu 和雷电）
     static bool convert_lf(std::string& data);
+    static bool convert_lf(RecvBuffer& data);
 
     AsstCallback m_callback;
 
@@ -115,6 +142,14 @@ protected:
     std::mutex m_callcmd_mutex;
 
     std::shared_ptr<asst::PlatformIO> m_platform_io = nullptr;
+    // 常驻的截图 shell，每帧只写入一条命令，省去 fork adb 进程和握手的开销
+    std::shared_ptr<IOHandler> m_screencap_stream = nullptr;
+    // 设备上常驻的 screenrecord，持续推送 H.264 码流，本机解码后直接取最新一帧
+    ScreenrecordStream m_h264_stream;
+    // 最近一次操作结束的时间，H264Stream 要取这之后解出的帧
+    std::atomic<std::chrono::steady_clock::time_point> m_last_action_time {};
+    // 已经等过新画面的那次操作的时间，同一次操作之后不再等
+    std::atomic<std::chrono::steady_clock::time_point> m_fresh_frame_waited {};
 
     struct AdbProperty
     {
@@ -127,6 +162,8 @@ protected:
         std::string press_esc;
 
         std::string screencap_raw_by_nc;
+        std::string screencap_raw_by_stream;
+        std::string screencap_h264_stream;
         std::string screencap_raw_with_gzip;
         std::string screencap_encode;
         std::string release;
@@ -152,6 +189,8 @@ protected:
             UnknownYet,
             // Default,
             RawByNc,
+            RawByStream,
+            H264Stream,
             RawWithGzip,
             Encode,
 #if ASST_WITH_EMULATOR_EXTRAS
@@ -173,6 +212,7 @@ protected:
     long long m_last_command_duration = 0;  // 上次命令执行用时
     std::deque<long long> m_screencap_cost; // 截图用时
     int m_screencap_times = 0;              // 截图次数
+    RecvBuffer m_screencap_buffer;          // 截图数据接收缓冲区，每帧复用
 
 #if ASST_WITH_EMULATOR_EXTRAS
     MumuExtras m_mumu_extras;
@@ -98,6 +98,13 @@ bool asst::ControlScaleProxy::swipe(const Rect& r1, const Rect& r2, int duration
     return swipe(rand_p1, rand_p2, duration, extra_swipe, slope_in, slope_out, with_pause);
 }
 
+bool asst::ControlScaleProxy::gesture(const Gesture& gesture)
+{
+    Log.trace("Gesture with scaled coordinates", gesture.steps().size(), gesture.duration(), m_control_scale);
+
+    return m_controller->gesture(gesture.scaled(m_control_scale));
+}
+
 bool asst::ControlScaleProxy::inject_input_event(InputEvent event)
 {
     switch (event.type) {
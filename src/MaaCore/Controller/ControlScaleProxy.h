@@ -4,6 +4,7 @@
 #include <random>
 
 #include "ControllerAPI.h"
+#include "Gesture.h"
 
 #include "Common/AsstMsg.h"
 
@@ -30,6 +31,8 @@ namespace asst
         bool swipe(const Rect& r1, const Rect& r2, int duration = 0, bool extra_swipe = false, double slope_in = 1,
                    double slope_out = 1, bool with_pause = false);
 
+        bool gesture(const Gesture& gesture);
+
         bool inject_input_event(InputEvent event);
 
         std::pair<int, int> get_scale_size() const noexcept;
@@ -39,6 +39,8 @@ asst::Controller::Controller(const AsstCallback& callback, Assistant* inst)
 asst::Controller::~Controller()
 {
     LogTraceFunction;
+
+    stop_prefetch();
 }
 
 std::shared_ptr<asst::ControllerAPI> asst::Controller::create_controller(
@@ -131,45 +133,73 @@ void asst::Controller::sync_params()
 
 bool asst::Controller::back_to_home()
 {
+    ActionScope action(*this);
     m_controller->back_to_home();
     return true;
 }
 
-cv::Mat asst::Controller::get_resized_image_cache() const
+asst::Controller::SharedFrame asst::Controller::get_resized_frame(uint64_t* frame_seq, FrameStamp* stamp) const
 {
     const static cv::Size d_size(m_scale_size.first, m_scale_size.second);
 
     std::shared_lock<std::shared_mutex> image_lock(m_image_mutex);
+    if (frame_seq) {
+        *frame_seq = m_cache_image.empty() ? 0 : m_change_tracker->frame_seq();
+    }
+    if (stamp) {
+        *stamp = { .fingerprint = m_cache_image.empty() ? 0 : m_frame_fingerprint,
+                   .action_count = m_action_count.load() };
+    }
     if (m_cache_image.empty()) {
         Log.error("image is empty");
-        return { d_size, CV_8UC3 };
+        return std::make_shared<const cv::Mat>(d_size, CV_8UC3);
+    }
+
+    // 内容版本相同说明和上次缩放的是同一个画面，像素完全一致
+    const uint64_t content_seq = m_change_tracker->content_seq();
+    std::unique_lock<std::mutex> resized_lock(m_resized_mutex);
+    if (m_resized_frame && m_resized_content_seq == content_seq && m_resized_frame->size() == d_size) {
+        return m_resized_frame;
     }
-    cv::Mat resized_mat;
-    cv::resize(m_cache_image, resized_mat, d_size, 0.0, 0.0, cv::INTER_AREA);
-    return resized_mat;
+
+    // m_cache_image 的内存之后会被下一帧复用，尺寸相同也得拷贝一份
+    auto resized = std::make_shared<cv::Mat>();
+    if (m_cache_image.size() == d_size) {
+        m_cache_image.copyTo(*resized);
+    }
+    else {
+        cv::resize(m_cache_image, *resized, d_size, 0.0, 0.0, cv::INTER_AREA);
+    }
+    m_resized_frame = std::move(resized);
+    m_resized_content_seq = content_seq;
+    return m_resized_frame;
 }
 
 bool asst::Controller::start_game(const std::string& client_type)
 {
     CHECK_EXIST(m_controller, false);
+    ActionScope action(*this);
     return m_controller->start_game(client_type);
 }
 
 bool asst::Controller::stop_game(const std::string& client_type)
 {
     CHECK_EXIST(m_controller, false);
+    ActionScope action(*this);
     return m_controller->stop_game(client_type);
 }
 
 bool asst::Controller::click(const Point& p)
 {
     CHECK_EXIST(m_controller, false);
+    ActionScope action(*this);
     return m_scale_proxy->click(p);
 }
 
 bool asst::Controller::click(const Rect& rect)
 {
     CHECK_EXIST(m_controller, false);
+    ActionScope action(*this);
     return m_scale_proxy->click(rect);
 }
 
@@ -183,6 +213,7 @@ bool asst::Controller::swipe(
     bool with_pause)
 {
     CHECK_EXIST(m_controller, false);
+    ActionScope action(*this);
     return m_scale_proxy->swipe(p1, p2, duration, extra_swipe, slope_in, slope_out, with_pause);
 }
 
@@ -196,12 +227,21 @@ bool asst::Controller::swipe(
     bool with_pause)
 {
     CHECK_EXIST(m_controller, false);
+    ActionScope action(*this);
     return m_scale_proxy->swipe(r1, r2, duration, extra_swipe, slope_in, slope_out, with_pause);
 }
 
+bool asst::Controller::gesture(const Gesture& gesture)
+{
+    CHECK_EXIST(m_controller, false);
+    ActionScope action(*this);
+    return m_scale_proxy->gesture(gesture);
+}
+
 bool asst::Controller::inject_input_event(InputEvent& event)
 {
     CHECK_EXIST(m_controller, false);
+    ActionScope action(*this);
     return m_controller->inject_input_event(event);
 }
 
@@ -210,6 +250,7 @@ bool asst::Controller::press_esc()
     LogTraceFunction;
 
     CHECK_EXIST(m_controller, false);
+    ActionScope action(*this);
     return m_controller->press_esc();
 }
 
@@ -226,6 +267,7 @@ bool asst::Controller::connect(
 {
     LogTraceFunction;
 
+    stop_prefetch();
     clear_info();
 
     m_controller = create_controller(m_controller_type, adb_path, address, config, m_platform_type);
@@ -325,16 +367,41 @@ void asst::Controller::set_kill_adb_on_exit(bool enable) noexcept
     sync_params();
 }
 
+void asst::Controller::set_screencap_prefetch(bool enable) noexcept
+{
+    // 线程在下次截图时由任务线程启动或停止
+    m_prefetch_enabled = enable;
+}
+
 const std::string& asst::Controller::get_uuid() const
 {
     return m_uuid;
 }
 
-cv::Mat asst::Controller::get_image(bool raw)
+cv::Mat asst::Controller::get_image(bool raw, std::chrono::milliseconds max_age)
+{
+    return capture_image(raw, nullptr, max_age);
+}
+
+cv::Mat asst::Controller::get_image(TileChangeTracker::FrameRef& frame, std::chrono::milliseconds max_age)
+{
+    uint64_t frame_seq = 0;
+    cv::Mat image = capture_image(false, &frame_seq, max_age);
+    frame = { .tracker = m_change_tracker, .seq = frame_seq };
+    return image;
+}
+
+cv::Mat asst::Controller::get_image(FrameStamp& stamp, std::chrono::milliseconds max_age)
+{
+    stamp = {};
+    return capture_image(false, nullptr, max_age, &stamp);
+}
+
+bool asst::Controller::refresh_image(std::chrono::milliseconds max_age)
 {
     if (get_scale_size() == std::pair(0, 0)) {
         Log.error("Unknown image size");
-        return {};
+        return false;
     }
 
     // 有些模拟器adb偶尔会莫名其妙截图失败，多试几次
@@ -344,7 +411,7 @@ cv::Mat asst::Controller::get_image(bool raw)
         if (need_exit()) {
             break;
         }
-        if (screencap()) {
+        if (update_image(max_age)) {
             success = true;
             break;
         }
@@ -363,28 +430,187 @@ cv::Mat asst::Controller::get_image(bool raw)
         callback(AsstMsg::ConnectionInfo, info);
 
         const static cv::Size d_size(m_scale_size.first, m_scale_size.second);
+        std::unique_lock<std::shared_mutex> image_lock(m_image_mutex);
         m_cache_image = cv::Mat(d_size, CV_8UC3);
+        m_change_tracker->reset();
+        m_frame_fingerprint = 0;
 
         break;
     }
 
+    return true;
+}
+
+void asst::Controller::finish_action() noexcept
+{
+    ++m_action_count;
+    if (m_controller) {
+        m_controller->on_action_finished(std::chrono::steady_clock::now());
+    }
+}
+
+cv::Mat asst::Controller::capture_image(
+    bool raw,
+    uint64_t* frame_seq,
+    std::chrono::milliseconds max_age,
+    FrameStamp* stamp)
+{
+    if (!refresh_image(max_age)) {
+        return {};
+    }
+
     if (raw) {
         std::shared_lock<std::shared_mutex> image_lock(m_image_mutex);
+        if (frame_seq) {
+            *frame_seq = m_change_tracker->frame_seq();
+        }
+        if (stamp) {
+            *stamp = { .fingerprint = m_frame_fingerprint, .action_count = m_action_count.load() };
+        }
         cv::Mat copy = m_cache_image.clone();
         return copy;
     }
 
-    return get_resized_image_cache();
+    return *get_resized_frame(frame_seq, stamp);
 }
 
 cv::Mat asst::Controller::get_image_cache() const
 {
-    return get_resized_image_cache();
+    return *get_resized_frame();
+}
+
+asst::Controller::SharedFrame asst::Controller::get_shared_image(std::chrono::milliseconds max_age)
+{
+    if (!refresh_image(max_age)) {
+        return std::make_shared<const cv::Mat>();
+    }
+    return get_resized_frame();
+}
+
+asst::Controller::SharedFrame asst::Controller::get_shared_image_cache() const
+{
+    return get_resized_frame();
 }
 
 bool asst::Controller::screencap(bool allow_reconnect)
 {
     CHECK_EXIST(m_controller, false);
-    std::unique_lock<std::shared_mutex> image_lock(m_image_mutex);
-    return m_controller->screencap(m_cache_image, allow_reconnect);
+    std::unique_lock<std::mutex> screencap_lock(m_screencap_mutex);
+
+    const auto start_time = std::chrono::steady_clock::now();
+    const size_t action_count = m_action_count;
+    bool ret = m_controller->screencap(m_capture_image, allow_reconnect);
+    {
+        std::unique_lock<std::shared_mutex> image_lock(m_image_mutex);
+        if (ret) {
+            m_change_tracker->update(m_cache_image, m_capture_image);
+            std::swap(m_cache_image, m_capture_image);
+            m_frame_fingerprint = m_change_tracker->content_seq();
+        }
+        else {
+            // 截图失败时保持上一帧不变
+            m_frame_fingerprint = 0;
+        }
+    }
+    {
+        std::unique_lock<std::mutex> prefetch_lock(m_prefetch_mutex);
+        m_capture_info = {
+            .times = m_capture_info.times + 1,
+            .success = ret,
+            .start_time = start_time,
+            .action_count = action_count,
+        };
+    }
+    m_prefetch_cv.notify_all();
+    return ret;
+}
+
+bool asst::Controller::update_image(std::chrono::milliseconds max_age)
+{
+    if (!m_prefetch_enabled) {
+        stop_prefetch();
+        return screencap();
+    }
+    // PlayTools 的截图和操作共用同一个连接；adb input 的操作要等截图的 adb 命令结束。都不适合预取
+    if (m_controller_type != ControllerType::Minitouch && m_controller_type != ControllerType::Maatouch) {
+        return screencap();
+    }
+    start_prefetch();
+    return wait_prefetched_image(max_age);
+}
+
+bool asst::Controller::wait_prefetched_image(std::chrono::milliseconds max_age)
+{
+    const auto request_time = std::chrono::steady_clock::now();
+    const auto not_before = request_time - max_age;
+    const size_t action_count = m_action_count;
+
+    std::unique_lock<std::mutex> lock(m_prefetch_mutex);
+    // 操作期间及之前开始截的帧都不能用
+    auto fresh = [&]() {
+        return m_capture_info.success && m_capture_info.action_count == action_count &&
+               m_capture_info.start_time >= not_before;
+    };
+    const uint64_t request_times = m_capture_info.times;
+    bool ret = true;
+    if (!fresh()) {
+        m_prefetch_demand = true;
+        m_prefetch_cv.notify_all();
+        m_prefetch_cv.wait(lock, [&]() {
+            if (m_prefetch_exit || m_capture_info.times == request_times) {
+                return m_prefetch_exit;
+            }
+            // 请求之后才开始的截图失败了，说明是真的截不到
+            return fresh() || (!m_capture_info.success && m_capture_info.start_time >= request_time);
+        });
+        ret = !m_prefetch_exit && fresh();
+    }
+
+    // 趁着分析这一帧，开始截下一帧
+    m_prefetch_demand = true;
+    m_prefetch_cv.notify_all();
+    return ret;
+}
+
+void asst::Controller::start_prefetch()
+{
+    if (m_prefetch_thread.joinable()) {
+        return;
+    }
+    Log.info("start screencap prefetch");
+    {
+        std::unique_lock<std::mutex> lock(m_prefetch_mutex);
+        m_prefetch_exit = false;
+        m_prefetch_demand = false;
+    }
+    m_prefetch_thread = std::thread(&Controller::prefetch_thread_func, this);
+}
+
+void asst::Controller::stop_prefetch()
+{
+    if (!m_prefetch_thread.joinable()) {
+        return;
+    }
+    Log.info("stop screencap prefetch");
+    {
+        std::unique_lock<std::mutex> lock(m_prefetch_mutex);
+        m_prefetch_exit = true;
+        m_prefetch_cv.notify_all();
+    }
+    m_prefetch_thread.join();
+}
+
+void asst::Controller::prefetch_thread_func()
+{
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_prefetch_mutex);
+            m_prefetch_cv.wait(lock, [&]() { return m_prefetch_exit || m_prefetch_demand; });
+            if (m_prefetch_exit) {
+                break;
+            }
+            m_prefetch_demand = false;
+        }
+        screencap();
+    }
 }
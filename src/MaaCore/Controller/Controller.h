@@ -1,6 +1,10 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <random>
 #include <shared_mutex>
@@ -15,6 +19,7 @@
 #include "Platform/AdbLiteIO.h"
 
 #include "ControllerAPI.h"
+#include "Gesture.h"
 
 #include "ControlScaleProxy.h"
 
@@ -23,6 +28,7 @@
 #include "InstHelper.h"
 #include "Utils/NoWarningCVMat.h"
 #include "Utils/SingletonHolder.hpp"
+#include "Vision/TileChangeTracker.h"
 #include "adb-lite/client.hpp"
 
 namespace asst
@@ -31,6 +37,23 @@ class Assistant;
 
 class Controller : private InstHelper
 {
+public:
+    // 画面版本 + 操作计数。两次取得的值相等，说明期间画面没有变化，也没有进行过任何操作
+    struct FrameStamp
+    {
+        uint64_t fingerprint = 0; // 画面内容最近一次变化时的帧序号，0 表示未知（还没截过图或截图失败）
+        size_t action_count = 0;
+
+        bool valid() const noexcept { return fingerprint != 0; }
+        bool operator==(const FrameStamp&) const = default;
+    };
+
+    // 开启截图预取时，get_image 默认可以接受的最旧的帧（从开始截图算起）
+    static constexpr std::chrono::milliseconds PrefetchMaxAgeDefault { 100 };
+
+    // 只读的共享帧（缩放后的）。画面不变时多次获取的是同一份数据，不会产生任何拷贝
+    using SharedFrame = std::shared_ptr<const cv::Mat>;
+
 public:
     Controller(const AsstCallback& callback, Assistant* inst);
     Controller(const Controller&) = delete;
@@ -51,6 +74,8 @@ public:
     void set_swipe_with_pause(bool enable) noexcept;
     void set_adb_lite_enabled(bool enable) noexcept;
     void set_kill_adb_on_exit(bool enable) noexcept;
+    // 截图预取：分析当前帧的同时，后台线程就开始截下一帧
+    void set_screencap_prefetch(bool enable) noexcept;
 
     const std::string& get_uuid() const;
 
@@ -60,8 +85,19 @@ public:
 
     ControllerType get_controller_type() const noexcept;
 
-    cv::Mat get_image(bool raw = false);
+    // max_age 仅在开启截图预取时生效：可以直接返回不超过 max_age 之前开始截的帧。
+    // 无论如何都不会返回在上一次操作（点击、滑动等）完成之前开始截的帧。
+    // raw = false 时返回的图像和缓存的共享帧共用内存，只能读，需要修改请先 clone
+    cv::Mat get_image(bool raw = false, std::chrono::milliseconds max_age = PrefetchMaxAgeDefault);
+    // 同 get_image，并给出这一帧在变化追踪中的位置，交给 VisionHelper::set_frame_ref 可以复用识别结果
+    cv::Mat get_image(
+        TileChangeTracker::FrameRef& frame,
+        std::chrono::milliseconds max_age = PrefetchMaxAgeDefault);
+    // 同 get_image，并给出这一帧的 FrameStamp。和图像在同一把锁下取得，不会被预取的下一帧抢先更新
+    cv::Mat get_image(FrameStamp& stamp, std::chrono::milliseconds max_age = PrefetchMaxAgeDefault);
     cv::Mat get_image_cache() const;
+    SharedFrame get_shared_image(std::chrono::milliseconds max_age = PrefetchMaxAgeDefault);
+    SharedFrame get_shared_image_cache() const;
     bool screencap(bool allow_reconnect = false);
 
     bool start_game(const std::string& client_type);
@@ -87,6 +123,8 @@ public:
         double slope_out = 1,
         bool with_pause = false);
 
+    bool gesture(const Gesture& gesture);
+
     bool inject_input_event(InputEvent& event);
 
     bool press_esc();
@@ -100,7 +138,41 @@ public:
     bool back_to_home();
 
 private:
-    cv::Mat get_resized_image_cache() const;
+    // 操作开始和结束时各计一次数，期间开始截的帧都视为过期
+    class ActionScope
+    {
+    public:
+        explicit ActionScope(Controller& ctrler) noexcept : m_ctrler(ctrler) { ++m_ctrler.m_action_count; }
+        ~ActionScope() { m_ctrler.finish_action(); }
+        ActionScope(const ActionScope&) = delete;
+        ActionScope& operator=(const ActionScope&) = delete;
+
+    private:
+        Controller& m_ctrler;
+    };
+
+    struct CaptureInfo
+    {
+        uint64_t times = 0; // 截图次数，包括失败的
+        bool success = false;
+        std::chrono::steady_clock::time_point start_time;
+        size_t action_count = 0; // 开始截图时的操作计数
+    };
+
+    bool refresh_image(std::chrono::milliseconds max_age);
+    void finish_action() noexcept;
+    cv::Mat capture_image(
+        bool raw,
+        uint64_t* frame_seq,
+        std::chrono::milliseconds max_age,
+        FrameStamp* stamp = nullptr);
+    SharedFrame get_resized_frame(uint64_t* frame_seq = nullptr, FrameStamp* stamp = nullptr) const;
+
+    bool update_image(std::chrono::milliseconds max_age);
+    bool wait_prefetched_image(std::chrono::milliseconds max_age);
+    void start_prefetch();
+    void stop_prefetch();
+    void prefetch_thread_func();
 
     void clear_info() noexcept;
     void callback(AsstMsg msg, const json::value& details);
@@ -127,5 +199,25 @@ private:
 
     mutable std::shared_mutex m_image_mutex;
     cv::Mat m_cache_image;
+    // 新的一帧先截到这里，截图期间 m_cache_image 仍然可以正常读取；截完后和 m_cache_image 比较、交换，
+    // 两块内存轮流使用
+    cv::Mat m_capture_image;
+    std::shared_ptr<TileChangeTracker> m_change_tracker = std::make_shared<TileChangeTracker>();
+    uint64_t m_frame_fingerprint = 0;
+    std::atomic<size_t> m_action_count = 0;
+
+    // 缩放后的帧按画面内容版本缓存，画面不变就不用重新缩放
+    mutable std::mutex m_resized_mutex;
+    mutable SharedFrame m_resized_frame = nullptr;
+    mutable uint64_t m_resized_content_seq = 0;
+
+    std::mutex m_screencap_mutex; // 同一时间只能有一个截图在进行
+    std::atomic<bool> m_prefetch_enabled = false;
+    bool m_prefetch_exit = false;
+    bool m_prefetch_demand = false;
+    CaptureInfo m_capture_info;
+    std::mutex m_prefetch_mutex;
+    std::condition_variable m_prefetch_cv;
+    std::thread m_prefetch_thread;
 };
 } // namespace asst
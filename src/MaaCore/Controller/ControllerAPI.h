@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <string>
 
 #include "Common/AsstTypes.h"
@@ -8,6 +9,7 @@
 namespace asst
 {
 struct InputEvent;
+class Gesture;
 
 enum class ControllerType
 {
@@ -53,7 +55,9 @@ public:
         double slope_in = 1,
         double slope_out = 1,
         bool with_pause = false) = 0;
-    // TODO: 抽象出gesture类
+
+    // 一次性下发整个手势，返回时手势已经执行完毕
+    virtual bool gesture(const Gesture& gesture) = 0;
 
     virtual bool inject_input_event(const InputEvent& event) = 0;
 
@@ -66,6 +70,9 @@ public:
     ControllerAPI& operator=(ControllerAPI&&) = delete;
 
     virtual void back_to_home() noexcept {}
+
+    // 一次操作（点击、滑动等）结束的时间，之后截的图应当是这之后的画面
+    virtual void on_action_finished([[maybe_unused]] std::chrono::steady_clock::time_point time) noexcept {}
 };
 
 struct InputEvent
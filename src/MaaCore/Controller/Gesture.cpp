@@ -0,0 +1,98 @@
+#include "Gesture.h"
+
+#include <cmath>
+
+static double cubic_spline(double slope_0, double slope_1, double t)
+{
+    const double a = slope_0;
+    const double b = -(2 * slope_0 + slope_1 - 3);
+    const double c = -(-slope_0 - slope_1 + 2);
+    return a * t + b * std::pow(t, 2) + c * std::pow(t, 3);
+}
+
+asst::Gesture& asst::Gesture::down(const Point& p, int contact)
+{
+    return push(InputEvent::Type::TOUCH_DOWN, p, contact);
+}
+
+asst::Gesture& asst::Gesture::move(const Point& p, int contact)
+{
+    return push(InputEvent::Type::TOUCH_MOVE, p, contact);
+}
+
+asst::Gesture& asst::Gesture::up(int contact)
+{
+    // 有些控制器抬起时也要带上坐标，用这个触点最后的位置
+    Point last;
+    for (auto iter = m_steps.crbegin(); iter != m_steps.crend(); ++iter) {
+        if (iter->event.pointerId == contact && (iter->event.type == InputEvent::Type::TOUCH_DOWN ||
+                                                 iter->event.type == InputEvent::Type::TOUCH_MOVE)) {
+            last = iter->event.point;
+            break;
+        }
+    }
+    return push(InputEvent::Type::TOUCH_UP, last, contact);
+}
+
+asst::Gesture& asst::Gesture::key(int key_code)
+{
+    InputEvent event;
+    event.keycode = key_code;
+    event.type = InputEvent::Type::KEY_DOWN;
+    m_steps.emplace_back(Step { .event = event, .time = m_time });
+    event.type = InputEvent::Type::KEY_UP;
+    m_steps.emplace_back(Step { .event = event, .time = m_time });
+    return *this;
+}
+
+asst::Gesture& asst::Gesture::wait(int ms)
+{
+    if (ms > 0) {
+        m_time += ms;
+    }
+    return *this;
+}
+
+asst::Gesture& asst::Gesture::move_along(
+    const Point& p1,
+    const Point& p2,
+    int duration,
+    double slope_in,
+    double slope_out,
+    int contact)
+{
+    for (int cur_time = DefaultMoveInterval; cur_time < duration; cur_time += DefaultMoveInterval) {
+        double progress = cubic_spline(slope_in, slope_out, static_cast<double>(cur_time) / duration);
+        int cur_x = static_cast<int>(std::lerp(p1.x, p2.x, progress));
+        int cur_y = static_cast<int>(std::lerp(p1.y, p2.y, progress));
+        move({ cur_x, cur_y }, contact).wait(DefaultMoveInterval);
+    }
+    return move(p2, contact).wait(DefaultMoveInterval);
+}
+
+asst::Gesture& asst::Gesture::swipe(const Point& p1, const Point& p2, int duration, double slope_in, double slope_out)
+{
+    down(p1).wait(DefaultClickDelay);
+    move_along(p1, p2, duration, slope_in, slope_out);
+    return up().wait(DefaultClickDelay);
+}
+
+asst::Gesture asst::Gesture::scaled(double scale) const
+{
+    Gesture result = *this;
+    for (auto& step : result.m_steps) {
+        step.event.point.x = static_cast<int>(step.event.point.x * scale);
+        step.event.point.y = static_cast<int>(step.event.point.y * scale);
+    }
+    return result;
+}
+
+asst::Gesture& asst::Gesture::push(InputEvent::Type type, const Point& p, int contact)
+{
+    InputEvent event;
+    event.type = type;
+    event.point = p;
+    event.pointerId = contact;
+    m_steps.emplace_back(Step { .event = event, .time = m_time });
+    return *this;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+
+#include "Common/AsstTypes.h"
+#include "ControllerAPI.h"
+
+namespace asst
+{
+// 一次完整的定时手势：按下、若干次移动、抬起（可以有多段），每一步都带有相对于手势开始的时间
+// 由控制器一次性下发，而不是每一步各写一次、各 sleep 一次
+class Gesture
+{
+public:
+    static constexpr int DefaultClickDelay = 50;
+    static constexpr int DefaultMoveInterval = 2;
+
+    struct Step
+    {
+        // 只会是 TOUCH_DOWN / TOUCH_MOVE / TOUCH_UP / KEY_DOWN / KEY_UP
+        InputEvent event;
+        int time = 0; // 相对于手势开始的毫秒数，同一时间的多步一起提交
+    };
+
+public:
+    Gesture& down(const Point& p, int contact = 0);
+    Gesture& move(const Point& p, int contact = 0);
+    Gesture& up(int contact = 0);
+    Gesture& key(int key_code);
+    Gesture& wait(int ms);
+
+    // 沿 cubic spline 从 p1 移动到 p2，每 DefaultMoveInterval 毫秒一个点，不包含按下和抬起
+    Gesture& move_along(
+        const Point& p1,
+        const Point& p2,
+        int duration,
+        double slope_in = 1,
+        double slope_out = 1,
+        int contact = 0);
+    // 按下、移动、抬起，各步的间隔和 MinitouchController::swipe 一致
+    Gesture& swipe(const Point& p1, const Point& p2, int duration, double slope_in = 1, double slope_out = 1);
+
+    const std::vector<Step>& steps() const noexcept { return m_steps; }
+    int duration() const noexcept { return m_time; }
+    bool empty() const noexcept { return m_steps.empty(); }
+
+    Gesture scaled(double scale) const;
+
+private:
+    Gesture& push(InputEvent::Type type, const Point& p, int contact);
+
+    std::vector<Step> m_steps;
+    int m_time = 0;
+};
+} // namespace asst
@@ -14,6 +14,7 @@
 #endif
 
 #include "Config/GeneralConfig.h"
+#include "Gesture.h"
 #include "Utils/NoWarningCV.h"
 
 asst::MaaThriftController::~MaaThriftController()
@@ -402,6 +403,39 @@ bool asst::MaaThriftController::swipe(const Point& p1, const Point& p2, int dura
     return ret;
 }
 
+bool asst::MaaThriftController::gesture(const Gesture& gesture)
+{
+    using namespace std::chrono;
+
+    if (!client_ || !transport_ || !transport_->isOpen()) {
+        Log.error("client_ is not created or transport_ is not open");
+        return false;
+    }
+
+    // 整个手势连同中间的等待攒成一批，只调用一次 inject_input_events
+    m_input_events.clear();
+    int cur_time = 0;
+    for (const auto& step : gesture.steps()) {
+        if (step.time > cur_time) {
+            InputEvent wait_event;
+            wait_event.type = InputEvent::Type::WAIT_MS;
+            wait_event.milisec = step.time - cur_time;
+            inject_input_event(wait_event);
+            cur_time = step.time;
+        }
+        inject_input_event(step.event);
+    }
+
+    const auto start_time = steady_clock::now();
+    InputEvent commit_event;
+    commit_event.type = InputEvent::Type::COMMIT;
+    if (!inject_input_event(commit_event)) {
+        return false;
+    }
+    std::this_thread::sleep_until(start_time + milliseconds(gesture.duration()));
+    return true;
+}
+
 bool asst::MaaThriftController::inject_input_event(const InputEvent& event)
 {
     if (!client_ || !transport_ || !transport_->isOpen()) {
@@ -44,6 +44,8 @@ namespace asst
         virtual bool swipe(const Point& p1, const Point& p2, int duration = 0, bool extra_swipe = false,
                            double slope_in = 1, double slope_out = 1, bool with_pause = false) override;
 
+        virtual bool gesture(const Gesture& gesture) override;
+
         virtual bool inject_input_event(const InputEvent& event) override;
 
         virtual bool press_esc() override;
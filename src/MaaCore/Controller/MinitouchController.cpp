@@ -5,6 +5,7 @@
 #include "Common/AsstTypes.h"
 #include "Config/GeneralConfig.h"
 #include "Utils/Logger.hpp"
+#include "Utils/Ranges.hpp"
 #include "Utils/StringMisc.hpp"
 
 asst::MinitouchController::~MinitouchController()
@@ -218,6 +219,33 @@ bool asst::MinitouchController::swipe(const Point& p1, const Point& p2, int dura
     return true;
 }
 
+bool asst::MinitouchController::gesture(const Gesture& gesture)
+{
+    if (!m_minitoucher) {
+        Log.error("minitoucher is not initialized");
+        return false;
+    }
+
+    auto is_key_event = [](const Gesture::Step& step) {
+        return step.event.type == InputEvent::Type::KEY_DOWN || step.event.type == InputEvent::Type::KEY_UP;
+    };
+    if (!m_use_maa_touch && ranges::any_of(gesture.steps(), is_key_event)) {
+        Log.error("minitouch does not support key event");
+        return false;
+    }
+
+    Log.trace(m_use_maa_touch ? "maatouch" : "minitouch", "gesture, steps:", gesture.steps().size(),
+              "duration:", gesture.duration());
+
+    // 只写入一次，本机从写入时刻起按手势总时长等待，而不是把每一步的等待累加起来再 sleep
+    const auto start_time = std::chrono::steady_clock::now();
+    if (!m_minitoucher->gesture(gesture)) return false;
+    m_minitoucher->clear();
+    std::this_thread::sleep_until(start_time +
+                                  std::chrono::milliseconds(gesture.duration() + Minitoucher::ExtraDelay));
+    return true;
+}
+
 bool asst::MinitouchController::inject_input_event(const InputEvent& event)
 {
     LogTraceFunction;
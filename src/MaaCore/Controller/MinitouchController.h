@@ -1,6 +1,7 @@
 #pragma once
 
 #include "AdbController.h"
+#include "Gesture.h"
 
 #include "Config/GeneralConfig.h"
 
@@ -28,6 +29,8 @@ namespace asst
         virtual bool swipe(const Point& p1, const Point& p2, int duration = 0, bool extra_swipe = false,
                            double slope_in = 1, double slope_out = 1, bool with_pause = false) override;
 
+        virtual bool gesture(const Gesture& gesture) override;
+
         virtual bool inject_input_event(const InputEvent& event) override;
 
         virtual ControlFeat::Feat support_features() const noexcept override;
@@ -113,6 +116,8 @@ namespace asst
                 return m_input_func(key_up_cmd(key_code, wait_ms, with_commit));
             }
             [[nodiscard]] bool wait(int ms) { return m_input_func(wait_cmd(ms)); }
+            // 整个手势拼成一段命令一次写入，步与步之间的间隔由设备端的 w 命令控制
+            [[nodiscard]] bool gesture(const Gesture& gesture) { return m_input_func(gesture_cmd(gesture)); }
             void clear() noexcept { m_wait_ms_count = 0; }
 
             void extra_sleep() { sleep(); }
@@ -194,6 +199,48 @@ namespace asst
                 sprintf(buff, "w %d\n", ms);
                 return buff;
             }
+
+            [[nodiscard]] std::string gesture_cmd(const Gesture& gesture)
+            {
+                std::string str;
+                int cur_time = 0;
+                bool uncommitted = false;
+                for (const auto& step : gesture.steps()) {
+                    if (step.time > cur_time) {
+                        if (uncommitted) str += commit_cmd();
+                        uncommitted = false;
+                        str += wait_cmd(step.time - cur_time);
+                        cur_time = step.time;
+                    }
+
+                    const auto& event = step.event;
+                    switch (event.type) {
+                    case InputEvent::Type::TOUCH_DOWN:
+                        str += down_cmd(event.point.x, event.point.y, 0, false, event.pointerId);
+                        break;
+                    case InputEvent::Type::TOUCH_MOVE:
+                        // 终点可以在屏幕外，但屏幕外的点就不发了，和 swipe 一致
+                        if (!in_range(event.point.x, event.point.y)) continue;
+                        str += move_cmd(event.point.x, event.point.y, 0, false, event.pointerId);
+                        break;
+                    case InputEvent::Type::TOUCH_UP:
+                        str += up_cmd(0, false, event.pointerId);
+                        break;
+                    case InputEvent::Type::KEY_DOWN:
+                        str += key_down_cmd(event.keycode, 0, false);
+                        break;
+                    case InputEvent::Type::KEY_UP:
+                        str += key_up_cmd(event.keycode, 0, false);
+                        break;
+                    default:
+                        continue;
+                    }
+                    uncommitted = true;
+                }
+                if (uncommitted) str += commit_cmd();
+                if (gesture.duration() > cur_time) str += wait_cmd(gesture.duration() - cur_time);
+                return str;
+            }
 #ifdef _MSC_VER
 #pragma warning(pop)
 #endif
@@ -205,6 +252,12 @@ namespace asst
             }
 
         private:
+            bool in_range(int x, int y) const noexcept
+            {
+                auto [c_x, c_y] = scale(x, y);
+                return c_x >= 0 && c_x <= m_props.max_x && c_y >= 0 && c_y <= m_props.max_y;
+            }
+
             Point scale(int x, int y) const noexcept
             {
                 switch (m_props.orientation) {
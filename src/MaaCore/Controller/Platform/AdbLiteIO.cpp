@@ -1,11 +1,13 @@
 #include "AdbLiteIO.h"
 
+#include <algorithm>
+#include <chrono>
 #include <regex>
 
 #include "Utils/Logger.hpp"
 
-std::optional<int> asst::AdbLiteIO::call_command(const std::string& cmd, bool recv_by_socket, std::string& pipe_data,
-                                                 std::string& sock_data, int64_t timeout,
+std::optional<int> asst::AdbLiteIO::call_command(const std::string& cmd, bool recv_by_socket, RecvBuffer& pipe_data,
+                                                 RecvBuffer& sock_data, int64_t timeout,
                                                  std::chrono::steady_clock::time_point start_time)
 {
     // TODO: 从上面的 call_command_win32/posix 里抽取出 socket 接收的部分
@@ -15,9 +17,7 @@ std::optional<int> asst::AdbLiteIO::call_command(const std::string& cmd, bool re
         return std::nullopt;
     }
 
-    // TODO: 实现 timeout，目前暂时忽略
-    std::ignore = timeout;
-    std::ignore = start_time;
+    // TODO: 实现 timeout，目前只有 shell 会话用到了
     std::smatch match;
     std::optional<int> ret;
 
@@ -27,11 +27,16 @@ std::optional<int> asst::AdbLiteIO::call_command(const std::string& cmd, bool re
     static const std::regex shell_regex(R"(^.+ -s \S+ shell (.+)$)");
     static const std::regex exec_regex(R"(^.+ -s \S+ exec-out (.+)$)");
     static const std::regex push_regex(R"#(^.+ -s \S+ push "(.+)" "(.+)"$)#");
+    // 可以走常驻 shell 会话的命令：很快就能结束。点击、按键、滑动最在乎延迟，也放进来，
+    // 命令发出去之后就不会再重发，不会被执行两次
+    static const std::regex session_regex(
+        R"(^\s*(getprop|settings get|dumpsys (window|input)|cat /proc/|chmod|am force-stop)"
+        R"(|input (tap|keyevent|swipe)\b).*$)");
 
     // adb devices
     if (std::regex_match(cmd, devices_regex)) {
         try {
-            pipe_data = adb::devices();
+            pipe_data.assign(adb::devices());
             ret = 0;
             goto ret_exit;
         }
@@ -62,7 +67,7 @@ std::optional<int> asst::AdbLiteIO::call_command(const std::string& cmd, bool re
         m_adb_client = adb::client::create(match[1].str()); // TODO: compare address with existing (if any)
 
         try {
-            pipe_data = m_adb_client->connect();
+            pipe_data.assign(m_adb_client->connect());
             ret = 0;
             goto ret_exit;
         }
@@ -85,8 +90,29 @@ std::optional<int> asst::AdbLiteIO::call_command(const std::string& cmd, bool re
         std::string command = match[1].str();
         remove_quotes(command);
 
+        // 白名单里的短命令走常驻的 shell 会话，不用每次都新建连接、重新握手
+        // 命令发出去之后再失败的，可能已经执行过了，不能再执行一次
+        if (std::regex_match(command, session_regex)) {
+            using namespace std::chrono;
+            const auto elapsed = duration_cast<milliseconds>(steady_clock::now() - start_time);
+            const auto remaining = milliseconds(timeout) - elapsed;
+            try {
+                pipe_data.assign(m_adb_client->session_shell(command, (std::max)(remaining, milliseconds(1))));
+                ret = 0;
+                goto ret_exit;
+            }
+            catch (const adb::session_unavailable& e) {
+                Log.warn("adb shell session unavailable:", e.what(), ", fallback to one-shot shell");
+            }
+            catch (const std::exception& e) {
+                Log.error("adb shell session failed:", e.what());
+                ret = -1;
+                goto ret_exit;
+            }
+        }
+
         try {
-            pipe_data = m_adb_client->shell(command);
+            pipe_data.assign(m_adb_client->shell(command));
             ret = 0;
             goto ret_exit;
         }
@@ -109,7 +135,7 @@ std::optional<int> asst::AdbLiteIO::call_command(const std::string& cmd, bool re
         remove_quotes(command);
 
         try {
-            pipe_data = m_adb_client->exec(command);
+            pipe_data.assign(m_adb_client->exec(command));
             ret = 0;
             goto ret_exit;
         }
@@ -183,8 +209,8 @@ std::shared_ptr<asst::IOHandler> asst::AdbLiteIO::interactive_shell(const std::s
 void asst::AdbLiteIO::release_adb(const std::string& adb_release, int64_t timeout)
 {
     if (m_adb_client) {
-        std::string pipe_data;
-        std::string sock_data;
+        RecvBuffer pipe_data;
+        RecvBuffer sock_data;
         auto start_time = std::chrono::steady_clock::now();
 
         call_command(adb_release, false, pipe_data, sock_data, timeout, start_time);
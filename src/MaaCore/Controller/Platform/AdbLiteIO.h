@@ -27,8 +27,8 @@ namespace asst
         AdbLiteIO(AdbLiteIO&&) = delete;
         virtual ~AdbLiteIO() = default;
 
-        virtual std::optional<int> call_command(const std::string& cmd, bool recv_by_socket, std::string& pipe_data,
-                                                std::string& sock_data, int64_t timeout,
+        virtual std::optional<int> call_command(const std::string& cmd, bool recv_by_socket, RecvBuffer& pipe_data,
+                                                RecvBuffer& sock_data, int64_t timeout,
                                                 std::chrono::steady_clock::time_point start_time) override;
 
         virtual std::shared_ptr<IOHandler> interactive_shell(const std::string& cmd) override;
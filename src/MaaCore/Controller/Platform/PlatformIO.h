@@ -1,14 +1,109 @@
 #pragma once
 
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <memory>
+#include <new>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
+
+#include "Utils/Platform.hpp"
 
 namespace asst
 {
     class IOHandler;
 
+    // 命令输出的接收缓冲区。按页对齐分配，扩容时不初始化新内存，只记录已写入的长度
+    // 截图时按一整帧预留好容量，每帧复用，接收过程中既不扩容也不清零
+    class RecvBuffer
+    {
+    public:
+        RecvBuffer() = default;
+        ~RecvBuffer() { platform::aligned_free(m_data); }
+
+        RecvBuffer(const RecvBuffer&) = delete;
+        RecvBuffer& operator=(const RecvBuffer&) = delete;
+
+        RecvBuffer(RecvBuffer&& other) noexcept
+            : m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0)),
+              m_capacity(std::exchange(other.m_capacity, 0))
+        {
+        }
+        RecvBuffer& operator=(RecvBuffer&& other) noexcept
+        {
+            if (this != &other) {
+                platform::aligned_free(m_data);
+                m_data = std::exchange(other.m_data, nullptr);
+                m_size = std::exchange(other.m_size, 0);
+                m_capacity = std::exchange(other.m_capacity, 0);
+            }
+            return *this;
+        }
+
+        char* data() noexcept { return m_data; }
+        const char* data() const noexcept { return m_data; }
+        size_t size() const noexcept { return m_size; }
+        size_t capacity() const noexcept { return m_capacity; }
+        bool empty() const noexcept { return m_size == 0; }
+        std::string_view view() const noexcept { return { m_data, m_size }; }
+
+        void clear() noexcept { m_size = 0; }
+        // 只能截短，不会写内存
+        void truncate(size_t size) noexcept { m_size = (std::min)(m_size, size); }
+
+        // 扩容到至少 capacity 字节，已写入的内容保留，新增的部分不初始化
+        void reserve(size_t capacity)
+        {
+            if (capacity <= m_capacity) {
+                return;
+            }
+            capacity = (capacity + platform::page_size - 1) / platform::page_size * platform::page_size;
+            auto* data = static_cast<char*>(platform::aligned_alloc(capacity, platform::page_size));
+            if (!data) {
+                throw std::bad_alloc();
+            }
+            if (m_size) {
+                std::memcpy(data, m_data, m_size);
+            }
+            platform::aligned_free(m_data);
+            m_data = data;
+            m_capacity = capacity;
+        }
+
+        // 保证末尾至少还有 min_free 字节可写，返回可写的起始位置；写完用 commit 记下写入的长度
+        char* prepare(size_t min_free)
+        {
+            if (m_capacity - m_size < min_free) {
+                reserve((std::max)(m_capacity * 2, m_size + min_free));
+            }
+            return m_data + m_size;
+        }
+        size_t free_size() const noexcept { return m_capacity - m_size; }
+        void commit(size_t len) noexcept { m_size += len; }
+
+        void append(std::string_view data)
+        {
+            if (data.empty()) {
+                return;
+            }
+            std::memcpy(prepare(data.size()), data.data(), data.size());
+            commit(data.size());
+        }
+        void assign(std::string_view data)
+        {
+            clear();
+            append(data);
+        }
+
+    private:
+        char* m_data = nullptr;
+        size_t m_size = 0;
+        size_t m_capacity = 0;
+    };
+
     enum class PlatformType
     {
         Native, // Win32IO or PosixIO
@@ -20,8 +115,8 @@ namespace asst
     public:
         virtual ~PlatformIO() = default;
 
-        virtual std::optional<int> call_command(const std::string& cmd, bool recv_by_socket, std::string& pipe_data,
-                                                std::string& sock_data, int64_t timeout,
+        virtual std::optional<int> call_command(const std::string& cmd, bool recv_by_socket, RecvBuffer& pipe_data,
+                                                RecvBuffer& sock_data, int64_t timeout,
                                                 std::chrono::steady_clock::time_point start_time) = 0;
 
         virtual std::optional<unsigned short> init_socket(const std::string& local_address) = 0;
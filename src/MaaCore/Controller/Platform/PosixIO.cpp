@@ -9,16 +9,49 @@
 #ifndef __APPLE__
 #include <sys/prctl.h>
 #endif
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 #include <cstring>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <climits>
+#include <optional>
+#include <string>
 
 #include "Common/AsstTypes.h"
 #include "Utils/Logger.hpp"
 #include "Utils/NoWarningCV.h"
 
+// 没有 pidfd 时检查子进程是否退出的间隔
+static constexpr int ChildCheckInterval = 5;
+// 子进程退出后，等待截图 socket 连接的最长时间
+static constexpr std::chrono::milliseconds SocketGraceAfterExit { 1000 };
+
+static int open_pidfd([[maybe_unused]] pid_t pid)
+{
+#if defined(__linux__) && defined(SYS_pidfd_open)
+    return static_cast<int>(::syscall(SYS_pidfd_open, pid, 0));
+#else
+    return -1;
+#endif
+}
+
+// 直接读到接收缓冲区已写入部分的后面，不经过中间缓冲区；预留的容量用完了才扩容
+static ssize_t read_into(int fd, asst::RecvBuffer& buffer)
+{
+    char* dest = buffer.prepare(1);
+    ssize_t read_num = ::read(fd, dest, buffer.free_size());
+    if (read_num > 0) {
+        buffer.commit(static_cast<size_t>(read_num));
+    }
+    return read_num;
+}
+
 asst::PosixIO::PosixIO(Assistant* inst) : InstHelper(inst)
 {
     LogTraceFunction;
@@ -37,13 +70,12 @@ asst::PosixIO::~PosixIO()
 }
 
 std::optional<int> asst::PosixIO::call_command(const std::string& cmd, const bool recv_by_socket,
-                                               std::string& pipe_data, std::string& sock_data, const int64_t timeout,
+                                               RecvBuffer& pipe_data, RecvBuffer& sock_data, const int64_t timeout,
                                                std::chrono::steady_clock::time_point start_time)
 {
     using namespace std::chrono;
 
     asst::platform::single_page_buffer<char> pipe_buffer;
-    asst::platform::single_page_buffer<char> sock_buffer;
 
     auto check_timeout = [&]() -> bool {
         return timeout && timeout < duration_cast<milliseconds>(steady_clock::now() - start_time).count();
@@ -93,51 +125,110 @@ std::optional<int> asst::PosixIO::call_command(const std::string& cmd, const boo
     }
 
     // parent process
-    if (recv_by_socket) {
-        sockaddr addr {};
-        socklen_t len = sizeof(addr);
-        sock_buffer = asst::platform::single_page_buffer<char>();
-
-        int client_socket = ::accept(m_server_sock, &addr, &len);
-        if (client_socket < 0) {
-            Log.error("accept failed:", strerror(errno));
-            ::kill(m_child, SIGTERM);
-            Log.error("Killing child `", cmd, "`, pid:", m_child);
-            ::kill(m_child, SIGKILL);
-            ::waitpid(m_child, &exit_ret, 0);
-            return std::nullopt;
+    // 子进程退出、stdout、截图 socket 放在同一个 poll 里等待，不再忙等
+    int pid_fd = open_pidfd(m_child);
+    int client_socket = -1;
+    bool accepting = recv_by_socket;
+    bool pipe_open = true;
+    bool child_exited = false;
+    steady_clock::time_point exit_time;
+
+    // 把 fd 里当前能读的全部读完，返回 false 表示对端已关闭
+    auto drain = [&](int fd, RecvBuffer* recv) -> bool {
+        while (true) {
+            ssize_t read_num = recv ? read_into(fd, *recv) : ::read(fd, pipe_buffer.get(), pipe_buffer.size());
+            if (read_num > 0 || (read_num < 0 && errno == EINTR)) {
+                continue;
+            }
+            return read_num < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
         }
+    };
+    // 走 socket 时 stdout 的内容没用，读出来丢掉即可
+    auto drain_pipe = [&]() {
+        pipe_open = drain(pipe_out[PIPE_READ], recv_by_socket ? nullptr : &pipe_data);
+    };
 
-        ssize_t read_num = ::read(client_socket, sock_buffer.get(), sock_buffer.size());
-        while (read_num > 0) {
-            sock_data.insert(sock_data.end(), sock_buffer.get(), sock_buffer.get() + read_num);
-            read_num = ::read(client_socket, sock_buffer.get(), sock_buffer.size());
+    while (true) {
+        std::array<::pollfd, 3> events {};
+        nfds_t events_size = 0;
+        auto add_event = [&](int fd) -> ::pollfd* {
+            events[events_size] = ::pollfd { .fd = fd, .events = POLLIN, .revents = 0 };
+            return &events[events_size++];
+        };
+        ::pollfd* pipe_event = pipe_open ? add_event(pipe_out[PIPE_READ]) : nullptr;
+        ::pollfd* sock_event = nullptr;
+        if (accepting) {
+            sock_event = add_event(m_server_sock);
         }
-        ::shutdown(client_socket, SHUT_RDWR);
-        ::close(client_socket);
-    }
+        else if (client_socket >= 0) {
+            sock_event = add_event(client_socket);
+        }
+        ::pollfd* child_event = (pid_fd >= 0 && !child_exited) ? add_event(pid_fd) : nullptr;
 
-    // has the child exited in the loop?
-    bool child_exited = false;
+        int wait_ms = -1;
+        if (timeout) {
+            auto remaining = timeout - duration_cast<milliseconds>(steady_clock::now() - start_time).count();
+            wait_ms = static_cast<int>(std::clamp<int64_t>(remaining, 0, INT_MAX));
+        }
+        if (child_exited && accepting) {
+            // 子进程都退出了还没连上来，最多再等一小会儿
+            auto remaining = SocketGraceAfterExit - duration_cast<milliseconds>(steady_clock::now() - exit_time);
+            int grace_ms = static_cast<int>(std::max<int64_t>(remaining.count(), 0));
+            wait_ms = wait_ms < 0 ? grace_ms : std::min(wait_ms, grace_ms);
+        }
+        else if (!child_exited && pid_fd < 0) {
+            // 没有 pidfd（非 Linux 或内核过旧），只能定期 waitpid
+            wait_ms = wait_ms < 0 ? ChildCheckInterval : std::min(wait_ms, ChildCheckInterval);
+        }
 
-    // whether we recv_by_socket or not, we have to
-    // drain the output pipe so that it doesn't block I/O.
-    // std::array<::pollfd, 1> events { ::pollfd { .fd = pipe_out[PIPE_READ], .events = POLLIN } };
-    while (true) {
-        ssize_t read_num = ::read(pipe_out[PIPE_READ], pipe_buffer.get(), pipe_buffer.size());
-        while (read_num > 0) {
-            if (!recv_by_socket) {
-                pipe_data.insert(pipe_data.end(), pipe_buffer.get(), pipe_buffer.get() + read_num);
+        if (::poll(events.data(), events_size, wait_ms) < 0 && errno != EINTR) {
+            Log.error("poll failed:", std::strerror(errno));
+            break;
+        }
+
+        if (pipe_event && pipe_event->revents) {
+            drain_pipe();
+        }
+        if (sock_event && sock_event->revents) {
+            if (accepting) {
+                sockaddr addr {};
+                socklen_t len = sizeof(addr);
+                client_socket = ::accept(m_server_sock, &addr, &len);
+                if (client_socket < 0) {
+                    Log.error("accept failed:", strerror(errno));
+                    break;
+                }
+                accepting = false;
+                ::fcntl(client_socket, F_SETFL, O_NONBLOCK);
+            }
+            if (!drain(client_socket, &sock_data)) {
+                ::shutdown(client_socket, SHUT_RDWR);
+                ::close(client_socket);
+                client_socket = -1;
             }
-            read_num = ::read(pipe_out[PIPE_READ], pipe_buffer.get(), pipe_buffer.size());
         }
-        if (read_num == -1 && errno == EAGAIN) {
-            // if (::poll(events.data(), events.size(), 1000) > 0) continue;
-            std::this_thread::yield();
+        if (!child_exited && (child_event ? child_event->revents != 0 : pid_fd < 0)) {
+            child_exited = ::waitpid(m_child, &exit_ret, child_event ? 0 : WNOHANG) == m_child;
+            if (child_exited) {
+                exit_time = steady_clock::now();
+                // 子进程退出前写下的内容都已经在管道里了，一次收完
+                if (pipe_open) {
+                    drain_pipe();
+                }
+            }
         }
-        else if (::waitpid(m_child, &exit_ret, WNOHANG) != 0) {
-            child_exited = true;
-            break;
+
+        if (child_exited) {
+            if (!recv_by_socket) {
+                break;
+            }
+            // 截图数据要等对端关闭 socket 才算收完
+            if (!accepting && client_socket < 0) {
+                break;
+            }
+            if (accepting && steady_clock::now() - exit_time >= SocketGraceAfterExit) {
+                break;
+            }
         }
         if (check_timeout()) {
             Log.warn("timeout when reading the output, killing child:", m_child);
@@ -145,6 +236,13 @@ std::optional<int> asst::PosixIO::call_command(const std::string& cmd, const boo
         }
     }
 
+    if (client_socket >= 0) {
+        ::shutdown(client_socket, SHUT_RDWR);
+        ::close(client_socket);
+    }
+    if (pid_fd >= 0) {
+        ::close(pid_fd);
+    }
     ::close(pipe_in[PIPE_WRITE]);
     ::close(pipe_out[PIPE_READ]);
 
@@ -155,6 +253,11 @@ std::optional<int> asst::PosixIO::call_command(const std::string& cmd, const boo
         ::waitpid(m_child, &exit_ret, 0);
     }
 
+    if (accepting) {
+        Log.error("no connection accepted from `", cmd, "`");
+        return std::nullopt;
+    }
+
     return exit_ret;
 }
 
@@ -273,8 +376,8 @@ std::shared_ptr<asst::IOHandler> asst::PosixIO::interactive_shell(const std::str
 void asst::PosixIO::release_adb(const std::string& adb_release, int64_t timeout)
 {
     if (m_child) {
-        std::string pipe_data;
-        std::string sock_data;
+        RecvBuffer pipe_data;
+        RecvBuffer sock_data;
         auto start_time = std::chrono::steady_clock::now();
 
         call_command(adb_release, false, pipe_data, sock_data, timeout, start_time);
@@ -309,6 +412,12 @@ std::string asst::IOHandlerPosix::read(unsigned timeout_sec)
 
     auto start_time = std::chrono::steady_clock::now();
 
+    // 先阻塞等到有数据可读（或超时），而不是让调用方反复空转
+    ::pollfd event { .fd = m_read_fd, .events = POLLIN, .revents = 0 };
+    if (::poll(&event, 1, static_cast<int>(timeout_sec * 1000)) <= 0) {
+        return ret_str;
+    }
+
     while (true) {
         char buf_from_child[PipeReadBuffSize];
 
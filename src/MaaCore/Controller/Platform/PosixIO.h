@@ -17,8 +17,8 @@ namespace asst
         PosixIO(PosixIO&&) = delete;
         virtual ~PosixIO();
 
-        virtual std::optional<int> call_command(const std::string& cmd, bool recv_by_socket, std::string& pipe_data,
-                                                std::string& sock_data, int64_t timeout,
+        virtual std::optional<int> call_command(const std::string& cmd, bool recv_by_socket, RecvBuffer& pipe_data,
+                                                RecvBuffer& sock_data, int64_t timeout,
                                                 std::chrono::steady_clock::time_point start_time) override;
 
         virtual std::optional<unsigned short> init_socket(const std::string& local_address) override;
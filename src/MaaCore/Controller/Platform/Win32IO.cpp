@@ -20,8 +20,8 @@ asst::Win32IO::~Win32IO()
     }
 }
 
-std::optional<int> asst::Win32IO::call_command(const std::string& cmd, bool recv_by_socket, std::string& pipe_data,
-                                               std::string& sock_data, int64_t timeout,
+std::optional<int> asst::Win32IO::call_command(const std::string& cmd, bool recv_by_socket, RecvBuffer& pipe_data,
+                                               RecvBuffer& sock_data, int64_t timeout,
                                                std::chrono::steady_clock::time_point start_time)
 {
     using namespace std::chrono;
@@ -187,7 +187,7 @@ std::optional<int> asst::Win32IO::call_command(const std::string& cmd, bool recv
             // pipe read
             DWORD len = 0;
             if (GetOverlappedResult(pipe_parent_read, &pipeov, &len, FALSE)) {
-                pipe_data.insert(pipe_data.end(), pipe_buffer.get(), pipe_buffer.get() + len);
+                pipe_data.append({ pipe_buffer.get(), len });
                 (void)ReadFile(pipe_parent_read, pipe_buffer.get(), (DWORD)pipe_buffer.size(), nullptr, &pipeov);
             }
             else {
@@ -203,7 +203,7 @@ std::optional<int> asst::Win32IO::call_command(const std::string& cmd, bool recv
                 DWORD len = 0;
                 if (GetOverlappedResult(reinterpret_cast<HANDLE>(m_server_sock), &sockov, &len, FALSE)) {
                     accept_pending = false;
-                    if (recv_by_socket) sock_data.insert(sock_data.end(), sock_buffer.get(), sock_buffer.get() + len);
+                    if (recv_by_socket) sock_data.append({ sock_buffer.get(), len });
 
                     if (len == 0) {
                         socket_eof = true;
@@ -224,7 +224,7 @@ std::optional<int> asst::Win32IO::call_command(const std::string& cmd, bool recv
                 // ReadFile
                 DWORD len = 0;
                 if (GetOverlappedResult(reinterpret_cast<HANDLE>(client_socket), &sockov, &len, FALSE)) {
-                    if (recv_by_socket) sock_data.insert(sock_data.end(), sock_buffer.get(), sock_buffer.get() + len);
+                    if (recv_by_socket) sock_data.append({ sock_buffer.get(), len });
                     if (len == 0) {
                         socket_eof = true;
                         ::closesocket(client_socket);
@@ -402,8 +402,8 @@ std::shared_ptr<asst::IOHandler> asst::Win32IO::interactive_shell(const std::str
 
 void asst::Win32IO::release_adb(const std::string& adb_release, int64_t timeout)
 {
-    std::string pipe_data;
-    std::string sock_data;
+    RecvBuffer pipe_data;
+    RecvBuffer sock_data;
     auto start_time = std::chrono::steady_clock::now();
 
     call_command(adb_release, false, pipe_data, sock_data, timeout, start_time);
@@ -442,19 +442,23 @@ std::string asst::IOHandlerWin32::read(unsigned timeout_sec)
     OVERLAPPED pipeov { .hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr) };
     std::ignore = ReadFile(m_read, pipe_buffer.get(), PipeBufferSize, nullptr, &pipeov);
 
+    DWORD len = 0;
     while (true) {
         if (!check_timeout(start_time)) {
             CancelIoEx(m_read, &pipeov);
+            // 等待取消完成，避免 pipeov 和 buffer 释放后还被写入
+            std::ignore = GetOverlappedResult(m_read, &pipeov, &len, TRUE);
             Log.error("read timeout");
             break;
         }
-        DWORD len = 0;
         if (GetOverlappedResult(m_read, &pipeov, &len, FALSE)) {
             break;
         }
     }
+    CloseHandle(pipeov.hEvent);
 
-    return pipe_buffer.get();
+    // 按实际读到的长度构造，截图流等二进制数据里会有 '\0'
+    return std::string(pipe_buffer.get(), len);
 }
 
 bool asst::IOHandlerWin32::write(std::string_view data)
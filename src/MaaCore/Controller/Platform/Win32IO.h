@@ -20,8 +20,8 @@ namespace asst
         Win32IO(Win32IO&&) = delete;
         virtual ~Win32IO();
 
-        virtual std::optional<int> call_command(const std::string& cmd, bool recv_by_socket, std::string& pipe_data,
-                                                std::string& sock_data, int64_t timeout,
+        virtual std::optional<int> call_command(const std::string& cmd, bool recv_by_socket, RecvBuffer& pipe_data,
+                                                RecvBuffer& sock_data, int64_t timeout,
                                                 std::chrono::steady_clock::time_point start_time) override;
 
         virtual std::optional<unsigned short> init_socket(const std::string& local_address) override;
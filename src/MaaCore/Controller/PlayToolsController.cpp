@@ -3,6 +3,7 @@
 #include <asio.hpp>
 
 #include "Config/GeneralConfig.h"
+#include "Gesture.h"
 #include "Utils/NoWarningCV.h"
 
 using asio::ip::tcp;
@@ -189,6 +190,50 @@ bool asst::PlayToolsController::swipe(
     return toucher_up(p2);
 }
 
+bool asst::PlayToolsController::gesture(const Gesture& gesture)
+{
+    using namespace std::chrono;
+
+    const auto width = m_screen_size.first;
+    const auto height = m_screen_size.second;
+
+    Log.trace("PlayTools gesture, steps:", gesture.steps().size(), "duration:", gesture.duration());
+
+    // PlayTools 每个触摸事件都要单独发送，按每一步的时间戳在本机定时，不累积 sleep 的误差
+    const auto start_time = steady_clock::now();
+    for (const auto& step : gesture.steps()) {
+        const auto& event = step.event;
+        if (event.pointerId != 0) {
+            Log.error("PlayTools does not support multi-touch gesture");
+            return false;
+        }
+        TouchPhase phase = TouchPhase::Began;
+        switch (event.type) {
+        case InputEvent::Type::TOUCH_DOWN:
+            phase = TouchPhase::Began;
+            break;
+        case InputEvent::Type::TOUCH_MOVE:
+            if (event.point.x < 0 || event.point.x > width || event.point.y < 0 || event.point.y > height) {
+                continue;
+            }
+            phase = TouchPhase::Moved;
+            break;
+        case InputEvent::Type::TOUCH_UP:
+            phase = TouchPhase::Ended;
+            break;
+        default:
+            Log.error("PlayTools does not support input event in gesture");
+            return false;
+        }
+        std::this_thread::sleep_until(start_time + milliseconds(step.time));
+        if (!toucher_commit(phase, event.point, 0)) {
+            return false;
+        }
+    }
+    std::this_thread::sleep_until(start_time + milliseconds(gesture.duration()));
+    return true;
+}
+
 bool asst::PlayToolsController::press_esc()
 {
     Log.info("ESC is not supported on iOS");
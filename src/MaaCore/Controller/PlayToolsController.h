@@ -51,6 +51,8 @@ public:
         double slope_out = 1,
         bool with_pause = false) override;
 
+    virtual bool gesture(const Gesture& gesture) override;
+
     virtual bool inject_input_event([[maybe_unused]] const InputEvent& event) override
     {
         return false;
@@ -0,0 +1,191 @@
+#include "ScreenrecordStream.h"
+
+#include <cstdlib>
+
+#include <asio.hpp>
+
+#include "Platform/PlatformIO.h"
+#include "Utils/Logger.hpp"
+#include "Utils/NoWarningCV.h"
+
+using asio::ip::tcp;
+
+// 裸流没有容器信息，FFmpeg 默认要攒够几 MB 或者几秒的数据才会探测完成，画面静止时会卡很久
+// OpenCV 只能通过环境变量设置这些选项。运行中修改环境变量和其他线程的 getenv 会冲突，
+// 所以在加载 MaaCore 时（还没有任何工作线程）设置一次。用户自己设置过的话就不覆盖了
+[[maybe_unused]] static const bool ffmpeg_capture_options_set = []() {
+    static constexpr const char* Key = "OPENCV_FFMPEG_CAPTURE_OPTIONS";
+    static constexpr const char* Value = "probesize;32768|analyzeduration;0|fflags;nobuffer|flags;low_delay";
+#ifdef _WIN32
+    size_t len = 0;
+    if (getenv_s(&len, nullptr, 0, Key) == 0 && len == 0) {
+        return _putenv_s(Key, Value) == 0;
+    }
+    return false;
+#else
+    return setenv(Key, Value, 0) == 0;
+#endif
+}();
+
+asst::ScreenrecordStream::~ScreenrecordStream()
+{
+    stop();
+}
+
+bool asst::ScreenrecordStream::start(std::shared_ptr<IOHandler> handler)
+{
+    LogTraceFunction;
+
+    stop();
+    if (!handler) {
+        return false;
+    }
+
+    unsigned short port = 0;
+    try {
+        m_acceptor = std::make_unique<tcp::acceptor>(m_context, tcp::endpoint(asio::ip::make_address("127.0.0.1"), 0));
+        m_acceptor->non_blocking(true);
+        port = m_acceptor->local_endpoint().port();
+    }
+    catch (const std::exception& e) {
+        Log.error("unable to listen for screenrecord stream:", e.what());
+        m_acceptor.reset();
+        return false;
+    }
+
+    m_handler = std::move(handler);
+    m_exit = false;
+    m_running = true;
+    m_feed_thread = std::thread(&ScreenrecordStream::feed_thread_func, this);
+    m_decode_thread = std::thread(&ScreenrecordStream::decode_thread_func, this, port);
+    return true;
+}
+
+void asst::ScreenrecordStream::stop() noexcept
+{
+    m_exit = true;
+    m_frame_cv.notify_all();
+    if (m_feed_thread.joinable()) {
+        m_feed_thread.join();
+    }
+    if (m_decode_thread.joinable()) {
+        m_decode_thread.join();
+    }
+
+    // 销毁会话时才会结束设备上的 screenrecord
+    m_handler.reset();
+    if (m_acceptor) {
+        asio::error_code ec;
+        m_acceptor->close(ec);
+        m_acceptor.reset();
+    }
+    m_running = false;
+
+    std::unique_lock<std::mutex> lock(m_frame_mutex);
+    m_frame.release();
+}
+
+bool asst::ScreenrecordStream::running() const noexcept
+{
+    return m_running;
+}
+
+bool asst::ScreenrecordStream::get_frame(
+    cv::Mat& image,
+    std::chrono::milliseconds timeout,
+    std::chrono::steady_clock::time_point not_before)
+{
+    std::unique_lock<std::mutex> lock(m_frame_mutex);
+    auto ready = [&]() {
+        return !m_frame.empty() && m_frame_time >= not_before;
+    };
+    m_frame_cv.wait_for(lock, timeout, [&]() { return ready() || !m_running; });
+    if (!ready()) {
+        return false;
+    }
+    m_frame.copyTo(image);
+    return true;
+}
+
+void asst::ScreenrecordStream::feed_thread_func()
+{
+    LogTraceFunction;
+
+    // 等解码线程连上来
+    m_socket = std::make_unique<tcp::socket>(m_context);
+    while (!m_exit && m_running) {
+        asio::error_code ec;
+        m_acceptor->accept(*m_socket, ec);
+        if (!ec) {
+            break;
+        }
+        if (ec != asio::error::would_block && ec != asio::error::try_again) {
+            Log.error("screenrecord stream accept failed:", ec.message());
+            m_running = false;
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    while (!m_exit && m_running && m_socket->is_open()) {
+        // 画面静止时 screenrecord 不会输出任何数据，读不到东西是正常的
+        std::string data = m_handler->read(1);
+        if (data.empty()) {
+            continue;
+        }
+        asio::error_code ec;
+        asio::write(*m_socket, asio::buffer(data), ec);
+        if (ec) {
+            Log.error("screenrecord stream write failed:", ec.message());
+            break;
+        }
+    }
+
+    // 关掉连接，FFmpeg 读到 EOF 后解码线程就会退出
+    asio::error_code ec;
+    m_socket->shutdown(tcp::socket::shutdown_both, ec);
+    m_socket->close(ec);
+    m_running = false;
+    m_frame_cv.notify_all();
+}
+
+void asst::ScreenrecordStream::decode_thread_func(unsigned short port)
+{
+    LogTraceFunction;
+
+    const std::string url = "tcp://127.0.0.1:" + std::to_string(port);
+    // 画面静止时可能很久都没有新数据，读超时设得足够长，退出时靠关闭连接来打断
+    const std::vector<int> params = {
+        cv::CAP_PROP_OPEN_TIMEOUT_MSEC,
+        10 * 1000,
+        cv::CAP_PROP_READ_TIMEOUT_MSEC,
+        24 * 3600 * 1000,
+    };
+    cv::VideoCapture capture;
+    if (!capture.open(url, cv::CAP_FFMPEG, params)) {
+        Log.error("unable to decode screenrecord stream");
+        m_running = false;
+        m_frame_cv.notify_all();
+        return;
+    }
+
+    cv::Mat frame;
+    while (!m_exit && capture.read(frame)) {
+        if (frame.empty()) {
+            continue;
+        }
+        {
+            std::unique_lock<std::mutex> lock(m_frame_mutex);
+            // 交换后旧的一帧留给下次 read 复用内存
+            cv::swap(m_frame, frame);
+            m_frame_time = std::chrono::steady_clock::now();
+        }
+        m_frame_cv.notify_all();
+    }
+    if (!m_exit) {
+        Log.warn("screenrecord stream ended");
+    }
+
+    m_running = false;
+    m_frame_cv.notify_all();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <asio/io_context.hpp>
+#include <asio/ip/tcp.hpp>
+
+#include "Utils/NoWarningCVMat.h"
+
+namespace asst
+{
+class IOHandler;
+
+// 持续读取设备上 screenrecord 输出的 H.264 裸流，在本机用 OpenCV (FFmpeg) 软解，
+// 始终保留最新解出的一帧。取图时不需要再向设备发送任何命令
+//
+// OpenCV 的 VideoCapture 没法直接从内存读数据，所以在本机回环地址上开一个端口，
+// 由转发线程把 adb 收到的字节流写进去，解码线程再用 tcp:// 地址连上来读
+class ScreenrecordStream
+{
+public:
+    ScreenrecordStream() = default;
+    ScreenrecordStream(const ScreenrecordStream&) = delete;
+    ScreenrecordStream(ScreenrecordStream&&) = delete;
+    ~ScreenrecordStream();
+
+    // handler: 已经启动的 screenrecord 会话，stdout 即为 H.264 裸流
+    bool start(std::shared_ptr<IOHandler> handler);
+    void stop() noexcept;
+    bool running() const noexcept;
+
+    // 取最新的一帧（BGR），写入 image，尺寸不变时复用 image 的内存
+    // 最新的一帧解出的时间早于 not_before 时（包括还没解出过任何一帧），最多等待 timeout
+    bool get_frame(
+        cv::Mat& image,
+        std::chrono::milliseconds timeout,
+        std::chrono::steady_clock::time_point not_before = {});
+
+    ScreenrecordStream& operator=(const ScreenrecordStream&) = delete;
+    ScreenrecordStream& operator=(ScreenrecordStream&&) = delete;
+
+private:
+    void feed_thread_func();
+    void decode_thread_func(unsigned short port);
+
+    std::shared_ptr<IOHandler> m_handler = nullptr;
+    asio::io_context m_context;
+    std::unique_ptr<asio::ip::tcp::acceptor> m_acceptor = nullptr;
+    std::unique_ptr<asio::ip::tcp::socket> m_socket = nullptr;
+
+    std::atomic<bool> m_exit = false;
+    std::atomic<bool> m_running = false;
+    std::thread m_feed_thread;
+    std::thread m_decode_thread;
+
+    mutable std::mutex m_frame_mutex;
+    std::condition_variable m_frame_cv;
+    cv::Mat m_frame; // 最新解出的一帧
+    std::chrono::steady_clock::time_point m_frame_time; // m_frame 解出的时间
+};
+} // namespace asst
@@ -1,5 +1,9 @@
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <optional>
 #include <thread>
 
 #include <asio.hpp>
@@ -89,11 +93,14 @@ namespace adb
 
     std::string io_handle_impl::read(unsigned timeout)
     {
-        std::array<char, 1024> buffer;
+        // Large enough to drain a raw screencap frame in a few reads.
+        constexpr size_t buffer_size = 64 * 1024;
+        std::string buffer(buffer_size, '\0');
 
         if (timeout == 0) {
             const auto bytes_read = m_socket.read_some(asio::buffer(buffer));
-            return std::string(buffer.data(), bytes_read);
+            buffer.resize(bytes_read);
+            return buffer;
         }
 
         std::error_code ec;
@@ -130,23 +137,81 @@ namespace adb
             }
         }
 
-        return std::string(buffer.data(), bytes_read);
+        buffer.resize(bytes_read);
+        return buffer;
     }
 
     void io_handle_impl::write(const std::string_view data)
     {
-        m_socket.write_some(asio::buffer(data));
+        asio::write(m_socket, asio::buffer(data));
+    }
+
+    /// Pre-handshaked connections of a device, shared with the thread refilling them.
+    /**
+     * @note The thread owns the pool as well, so the client can leave the thread behind if it is
+     * stuck on an unresponsive server.
+     */
+    struct connection_pool
+    {
+        /// Number of connections kept.
+        static constexpr size_t size = 2;
+
+        std::string serial;
+        tcp_endpoints endpoints;
+        asio::io_context context;
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<tcp::socket> sockets;
+        bool exit = false;
+        bool stopped = false;
+    };
+
+    /// Keep the pool filled, run in the background thread.
+    static void refill_pool(const std::shared_ptr<connection_pool> pool)
+    {
+        std::unique_lock<std::mutex> lock(pool->mutex);
+        while (!pool->exit) {
+            if (pool->sockets.size() >= connection_pool::size) {
+                pool->cv.wait(lock);
+                continue;
+            }
+            lock.unlock();
+
+            std::optional<tcp::socket> socket;
+            try {
+                tcp::socket new_socket(pool->context);
+                asio::connect(new_socket, pool->endpoints);
+                send_host_request(new_socket, "host:transport:" + pool->serial);
+                socket.emplace(std::move(new_socket));
+            }
+            catch (const std::exception&) {
+                // The device may be offline, retry later.
+            }
+
+            lock.lock();
+            if (!socket) {
+                pool->cv.wait_for(lock, std::chrono::seconds(1), [&]() { return pool->exit; });
+            }
+            else if (!pool->exit) {
+                pool->sockets.emplace_back(std::move(*socket));
+            }
+        }
+        pool->stopped = true;
+        pool->cv.notify_all();
     }
 
     class client_impl : public client
     {
     public:
         client_impl(const std::string_view serial);
+        ~client_impl() override;
         std::string connect() override;
         std::string disconnect() override;
         std::string version() override;
         std::string devices() override;
         std::string shell(const std::string_view command) override;
+        std::string session_shell(const std::string_view command, std::chrono::milliseconds timeout) override;
         std::string exec(const std::string_view command) override;
         bool push(const std::string_view src, const std::string_view dst, int perm) override;
         std::shared_ptr<io_handle> interactive_shell(const std::string_view command) override;
@@ -157,10 +222,19 @@ namespace adb
     private:
         friend class client;
 
+        /// How long the destructor waits for the pool thread before leaving it behind.
+        static constexpr std::chrono::seconds pool_stop_timeout { 3 };
+
         std::string m_serial;
         asio::io_context m_context;
         tcp_endpoints m_endpoints;
 
+        std::shared_ptr<connection_pool> m_pool;
+        std::thread m_pool_thread;
+
+        std::mutex m_session_mutex;
+        std::shared_ptr<io_handle> m_session = nullptr;
+
         /// Switch the connection to the device.
         /**
          * @param socket Opened adb connection.
@@ -168,6 +242,19 @@ namespace adb
          * @note Local services (e.g. shell, push) can be requested after this.
          */
         void switch_to_device(asio::ip::tcp::socket& socket);
+
+        /// Open a local service on the device.
+        /**
+         * @param request Service request, e.g. `shell:<command>`.
+         * @return Opened adb connection, ready to transfer data of the service.
+         * @throw std::system_error if the server is not available.
+         * @note A pre-handshaked connection from the pool is used if possible, so only the service
+         * request itself is sent. If it turns out to be stale, a new connection is made instead.
+         */
+        tcp::socket open_device_service(const std::string_view request);
+
+        /// Take a pre-handshaked connection from the pool, and start refilling the pool.
+        std::optional<tcp::socket> take_pooled_socket();
     };
 
     std::shared_ptr<client> client::create(const std::string_view serial)
@@ -181,6 +268,31 @@ namespace adb
 
         tcp::resolver resolver(m_context);
         m_endpoints = resolver.resolve("127.0.0.1", "5037");
+
+        m_pool = std::make_shared<connection_pool>();
+        m_pool->serial = m_serial;
+        m_pool->endpoints = m_endpoints;
+    }
+
+    client_impl::~client_impl()
+    {
+        std::unique_lock<std::mutex> lock(m_pool->mutex);
+        m_pool->exit = true;
+        m_pool->sockets.clear();
+        m_pool->cv.notify_all();
+        if (!m_pool_thread.joinable()) {
+            return;
+        }
+
+        // Connecting to an unresponsive server blocks without a timeout, do not hang on it.
+        const bool stopped = m_pool->cv.wait_for(lock, pool_stop_timeout, [&]() { return m_pool->stopped; });
+        lock.unlock();
+        if (stopped) {
+            m_pool_thread.join();
+        }
+        else {
+            m_pool_thread.detach();
+        }
     }
 
     std::string client_impl::connect()
@@ -217,40 +329,92 @@ namespace adb
 
     std::string client_impl::shell(const std::string_view command)
     {
-        tcp::socket socket(m_context);
-        asio::connect(socket, m_endpoints);
-
-        switch_to_device(socket);
-
         const auto request = std::string("shell:") + command.data();
-        send_host_request(socket, request);
+        auto socket = open_device_service(request);
 
         return protocol::host_data(socket);
     }
 
-    std::string client_impl::exec(const std::string_view command)
+    std::string client_impl::session_shell(const std::string_view command, std::chrono::milliseconds timeout)
     {
-        tcp::socket socket(m_context);
-        asio::connect(socket, m_endpoints);
+        constexpr std::string_view sentinel = "__ADB_LITE_SESSION_END__";
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+        // Run the command in a group so that redirections apply to the whole pipeline, and keep
+        // it from eating the rest of the session's stdin.
+        std::string request = "{ ";
+        request.append(command);
+        request.append("\n} </dev/null 2>&1; echo ");
+        request.append(sentinel);
+        request.append("\n");
+
+        std::unique_lock<std::mutex> lock(m_session_mutex);
+        try {
+            if (!m_session) {
+                m_session = interactive_shell("sh");
+            }
+            m_session->write(request);
+        }
+        catch (const std::exception& e) {
+            // A partially written group is never run: the session is closed before the closing
+            // brace arrives, and sh only reports a syntax error at EOF.
+            m_session.reset();
+            throw session_unavailable(e.what());
+        }
 
-        switch_to_device(socket);
+        try {
+            std::string output;
+            while (true) {
+                unsigned read_timeout = 0;
+                if (timeout.count() > 0) {
+                    const auto remaining = deadline - std::chrono::steady_clock::now();
+                    if (remaining <= std::chrono::steady_clock::duration::zero()) {
+                        throw std::runtime_error("shell session timed out");
+                    }
+                    read_timeout = static_cast<unsigned>(std::chrono::ceil<std::chrono::seconds>(remaining).count());
+                }
+                const auto data = m_session->read(read_timeout);
+                if (data.empty()) {
+                    throw std::runtime_error("shell session closed or timed out");
+                }
+                output.append(data);
+
+                std::string_view view(output);
+                if (view.ends_with("\r\n")) {
+                    view.remove_suffix(2);
+                }
+                else if (view.ends_with("\n")) {
+                    view.remove_suffix(1);
+                }
+                else {
+                    continue;
+                }
+                if (view.ends_with(sentinel)) {
+                    output.resize(view.size() - sentinel.size());
+                    return output;
+                }
+            }
+        }
+        catch (...) {
+            // The session may still be running the command, or left with partial output.
+            m_session.reset();
+            throw;
+        }
+    }
 
+    std::string client_impl::exec(const std::string_view command)
+    {
         const auto request = std::string("exec:") + command.data();
-        send_host_request(socket, request);
+        auto socket = open_device_service(request);
 
         return protocol::host_data(socket);
     }
 
     bool client_impl::push(const std::string_view src, const std::string_view dst, int perm)
     {
-        tcp::socket socket(m_context);
-        asio::connect(socket, m_endpoints);
-
-        switch_to_device(socket);
-
         // Switch to sync mode
         const auto sync = "sync:";
-        send_host_request(socket, sync);
+        auto socket = open_device_service(sync);
 
         // SEND request: destination, permissions
         const auto send_request = std::string(dst) + "," + std::to_string(perm);
@@ -340,4 +504,44 @@ namespace adb
         const auto request = "host:transport:" + m_serial;
         send_host_request(socket, request);
     }
+
+    tcp::socket client_impl::open_device_service(const std::string_view request)
+    {
+        if (auto pooled = take_pooled_socket()) {
+            try {
+                send_host_request(*pooled, request);
+                return std::move(*pooled);
+            }
+            catch (const std::exception&) {
+                // The server closes idle transports when the device goes offline or adbd restarts.
+                // The service has not been started in this case, so it is safe to retry.
+            }
+        }
+
+        tcp::socket socket(m_context);
+        asio::connect(socket, m_endpoints);
+
+        switch_to_device(socket);
+        send_host_request(socket, request);
+
+        return socket;
+    }
+
+    std::optional<tcp::socket> client_impl::take_pooled_socket()
+    {
+        std::unique_lock<std::mutex> lock(m_pool->mutex);
+        if (!m_pool_thread.joinable()) {
+            // Started on first use, as the transport is not available before `connect()`.
+            m_pool_thread = std::thread(refill_pool, m_pool);
+        }
+        if (m_pool->sockets.empty()) {
+            return std::nullopt;
+        }
+
+        auto socket = std::move(m_pool->sockets.front());
+        m_pool->sockets.pop_front();
+        lock.unlock();
+        m_pool->cv.notify_all();
+        return socket;
+    }
 } // namespace adb
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 
@@ -28,6 +30,17 @@ namespace adb
      */
     void kill_server();
 
+    /// The persistent shell session could not be opened or written to.
+    /**
+     * @note Nothing has reached the device in this case, so the command can be sent again in
+     * another way.
+     */
+    class session_unavailable : public std::runtime_error
+    {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
     class io_handle_impl;
 
     /// Context for an interactive adb connection.
@@ -121,6 +134,22 @@ namespace adb
          */
         virtual std::string shell(const std::string_view command) = 0;
 
+        /// Send a short shell command through a persistent shell session.
+        /**
+         * @param command Command to execute. Its stdin is redirected from /dev/null.
+         * @param timeout Timeout of the whole command. 0 or less means no timeout.
+         * @return A string of the command output, with stderr merged.
+         * @throw adb::session_unavailable if the session cannot be opened or written to. The
+         * command has not been sent.
+         * @throw std::runtime_error if the session is closed or times out after the command has
+         * been sent. The command may have run, so it should not be sent again.
+         * @note The session is dropped on any failure and reopened on the next call.
+         * @note The session is opened on first use and reused afterwards, so no new adb connection or
+         * transport handshake is made per command. The output is delimited by a sentinel echoed after
+         * the command.
+         */
+        virtual std::string session_shell(const std::string_view command, std::chrono::milliseconds timeout) = 0;
+
         /// Send an one-shot shell command to the device, using raw PTY.
         /**
          * @param command Command to execute.
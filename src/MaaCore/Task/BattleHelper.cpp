@@ -52,6 +52,9 @@ void asst::BattleHelper::clear()
     m_cur_deployment_opers.clear();
     m_battlefield_opers.clear();
     m_used_tiles.clear();
+
+    m_tracked_image.release();
+    m_tracked_frame = {};
 }
 
 bool asst::BattleHelper::calc_tiles_info(
@@ -103,13 +106,14 @@ bool asst::BattleHelper::update_deployment(bool init, const cv::Mat& reusable, b
         wait_until_start(false);
     }
 
-    cv::Mat image = init || reusable.empty() ? m_inst_helper.ctrler()->get_image() : reusable;
+    cv::Mat image = init || reusable.empty() ? get_tracked_image() : reusable;
 
     if (init) {
         auto draw_future = std::async(std::launch::async, [&]() { save_map(image); });
     }
 
     BattlefieldMatcher oper_analyzer(image);
+    oper_analyzer.set_frame_ref(get_frame_ref(image));
 
     // 保全要识别开局费用，先用init判断了，之后别的地方要用的话再做cache
     if (init || need_oper_cost) {
@@ -153,6 +157,8 @@ bool asst::BattleHelper::update_deployment(bool init, const cv::Mat& reusable, b
     for (auto& oper : cur_opers) {
         BestMatcher avatar_analyzer(oper.avatar);
         avatar_analyzer.set_method(MatchMethod::Ccoeff);
+        // 整个 AvatarCache 都要和这一个头像比，模板大小都一样，一起算快得多
+        avatar_analyzer.set_batch(true);
         if (oper.cooling) {
             Log.trace("start matching cooling", oper.index);
             static const auto cooling_threshold =
@@ -253,7 +259,7 @@ bool asst::BattleHelper::update_deployment(bool init, const cv::Mat& reusable, b
 
             click_oper_on_deployment(oper_rect);
 
-            name_image = m_inst_helper.ctrler()->get_image();
+            name_image = get_tracked_image();
             if (!check_in_battle(name_image)) {
                 return false;
             }
@@ -275,7 +281,7 @@ bool asst::BattleHelper::update_deployment(bool init, const cv::Mat& reusable, b
             cancel_oper_selection();
         }
 
-        image = m_inst_helper.ctrler()->get_image();
+        image = get_tracked_image();
     }
 
     if (init) {
@@ -287,8 +293,9 @@ bool asst::BattleHelper::update_deployment(bool init, const cv::Mat& reusable, b
 
 bool asst::BattleHelper::update_kills(const cv::Mat& reusable)
 {
-    cv::Mat image = reusable.empty() ? m_inst_helper.ctrler()->get_image() : reusable;
+    cv::Mat image = reusable.empty() ? get_tracked_image() : reusable;
     BattlefieldMatcher analyzer(image);
+    analyzer.set_frame_ref(get_frame_ref(image));
     analyzer.set_object_of_interest({ .kills = true });
     if (m_total_kills) {
         analyzer.set_total_kills_prompt(m_total_kills);
@@ -303,8 +310,9 @@ bool asst::BattleHelper::update_kills(const cv::Mat& reusable)
 
 bool asst::BattleHelper::update_cost(const cv::Mat& reusable)
 {
-    cv::Mat image = reusable.empty() ? m_inst_helper.ctrler()->get_image() : reusable;
+    cv::Mat image = reusable.empty() ? get_tracked_image() : reusable;
     BattlefieldMatcher analyzer(image);
+    analyzer.set_frame_ref(get_frame_ref(image));
     analyzer.set_object_of_interest({ .costs = true });
     auto result_opt = analyzer.analyze();
     if (!result_opt || !result_opt->costs) {
@@ -351,16 +359,9 @@ bool asst::BattleHelper::deploy_oper(
         m_inst_helper.ctrler()->support_features(),
         ControlFeat::SWIPE_WITH_PAUSE);
     Point oper_point(oper_rect.x + oper_rect.width / 2, oper_rect.y + oper_rect.height / 2);
-    m_inst_helper.ctrler()->swipe(
-        oper_point,
-        target_point,
-        duration,
-        false,
-        swipe_oper_task_ptr->special_params.at(2),
-        swipe_oper_task_ptr->special_params.at(3),
-        deploy_with_pause);
 
     // 拖动干员朝向
+    std::optional<Point> direction_end_point;
     if (direction != DeployDirection::None) {
         static const std::unordered_map<DeployDirection, Point> DirectionMap = {
             { DeployDirection::Right, Point::right() }, { DeployDirection::Down, Point::down() },
@@ -383,12 +384,42 @@ bool asst::BattleHelper::deploy_oper(
             scale_size.first,
             scale_size.second,
             swipe_oper_task_ptr->special_params.at(1));
-
-        m_inst_helper.sleep(use_oper_task_ptr->post_delay);
-        m_inst_helper.ctrler()->swipe(target_point, end_point, swipe_oper_task_ptr->post_delay);
+        direction_end_point = end_point;
+    }
+
+    if (direction_end_point && !deploy_with_pause) {
+        // 拖上场、停顿、拖朝向拼成一个手势一次下发，中间不再逐步写入和 sleep
+        Gesture gesture;
+        gesture
+            .swipe(
+                oper_point,
+                target_point,
+                duration,
+                swipe_oper_task_ptr->special_params.at(2),
+                swipe_oper_task_ptr->special_params.at(3))
+            .wait(use_oper_task_ptr->post_delay)
+            .swipe(target_point, *direction_end_point, swipe_oper_task_ptr->post_delay);
+        m_inst_helper.ctrler()->gesture(gesture);
         // 仅简单复用，该延迟含义与此处逻辑无关 by MistEO
         m_inst_helper.sleep(use_oper_task_ptr->pre_delay);
     }
+    else {
+        m_inst_helper.ctrler()->swipe(
+            oper_point,
+            target_point,
+            duration,
+            false,
+            swipe_oper_task_ptr->special_params.at(2),
+            swipe_oper_task_ptr->special_params.at(3),
+            deploy_with_pause);
+
+        if (direction_end_point) {
+            m_inst_helper.sleep(use_oper_task_ptr->post_delay);
+            m_inst_helper.ctrler()->swipe(target_point, *direction_end_point, swipe_oper_task_ptr->post_delay);
+            // 仅简单复用，该延迟含义与此处逻辑无关 by MistEO
+            m_inst_helper.sleep(use_oper_task_ptr->pre_delay);
+        }
+    }
 
     if (deploy_with_pause) {
         // m_inst_helper.ctrler()->press_esc();
@@ -476,12 +507,14 @@ bool asst::BattleHelper::use_skill(const Point& loc, bool keep_waiting)
 
 bool asst::BattleHelper::check_pause_button(const cv::Mat& reusable)
 {
-    cv::Mat image = reusable.empty() ? m_inst_helper.ctrler()->get_image() : reusable;
+    cv::Mat image = reusable.empty() ? get_tracked_image() : reusable;
     Matcher battle_flag_analyzer(image);
     battle_flag_analyzer.set_task_info("BattleOfficiallyBegin");
+    battle_flag_analyzer.set_frame_ref(get_frame_ref(image));
     bool ret = battle_flag_analyzer.analyze().has_value();
 
     BattlefieldMatcher battle_flag_analyzer_2(image);
+    battle_flag_analyzer_2.set_frame_ref(get_frame_ref(image));
     auto battle_result_opt = battle_flag_analyzer_2.analyze();
     ret &= battle_result_opt && battle_result_opt->pause_button;
     return ret;
@@ -489,10 +522,11 @@ bool asst::BattleHelper::check_pause_button(const cv::Mat& reusable)
 
 bool asst::BattleHelper::check_skip_plot_button(const cv::Mat& reusable)
 {
-    cv::Mat image = reusable.empty() ? m_inst_helper.ctrler()->get_image() : reusable;
+    cv::Mat image = reusable.empty() ? get_tracked_image() : reusable;
 
     Matcher battle_plot_analyzer(image);
     battle_plot_analyzer.set_task_info("SkipThePreBattlePlot");
+    battle_plot_analyzer.set_frame_ref(get_frame_ref(image));
     bool ret = battle_plot_analyzer.analyze().has_value();
     if (ret) {
         ProcessTask(this_task(), { "SkipThePreBattlePlot" }).run();
@@ -502,17 +536,19 @@ bool asst::BattleHelper::check_skip_plot_button(const cv::Mat& reusable)
 
 bool asst::BattleHelper::check_in_speed_up(const cv::Mat& reusable)
 {
-    cv::Mat image = reusable.empty() ? m_inst_helper.ctrler()->get_image() : reusable;
+    cv::Mat image = reusable.empty() ? get_tracked_image() : reusable;
     Matcher analyzer(image);
     analyzer.set_task_info("BattleSpeedUpCheck");
+    analyzer.set_frame_ref(get_frame_ref(image));
     return analyzer.analyze().has_value();
 }
 
 bool asst::BattleHelper::check_in_battle(const cv::Mat& reusable, bool weak)
 {
-    cv::Mat image = reusable.empty() ? m_inst_helper.ctrler()->get_image() : reusable;
+    cv::Mat image = reusable.empty() ? get_tracked_image() : reusable;
     if (weak) {
         BattlefieldMatcher analyzer(image);
+        analyzer.set_frame_ref(get_frame_ref(image));
         m_in_battle = analyzer.analyze().has_value();
     }
     else {
@@ -526,12 +562,12 @@ bool asst::BattleHelper::wait_until_start(bool weak)
 {
     LogTraceFunction;
 
-    cv::Mat image = m_inst_helper.ctrler()->get_image();
+    cv::Mat image = get_tracked_image();
     while (!m_inst_helper.need_exit() && !check_in_battle(image, weak)) {
         do_strategic_action(image);
         std::this_thread::yield();
 
-        image = m_inst_helper.ctrler()->get_image();
+        image = get_tracked_image();
     }
     return true;
 }
@@ -540,19 +576,19 @@ bool asst::BattleHelper::wait_until_end(bool weak)
 {
     LogTraceFunction;
 
-    cv::Mat image = m_inst_helper.ctrler()->get_image();
+    cv::Mat image = get_tracked_image();
     while (!m_inst_helper.need_exit() && check_in_battle(image, weak)) {
         do_strategic_action(image);
         std::this_thread::yield();
 
-        image = m_inst_helper.ctrler()->get_image();
+        image = get_tracked_image();
     }
     return true;
 }
 
 bool asst::BattleHelper::do_strategic_action(const cv::Mat& reusable)
 {
-    cv::Mat image = reusable.empty() ? m_inst_helper.ctrler()->get_image() : reusable;
+    cv::Mat image = reusable.empty() ? get_tracked_image() : reusable;
     return use_all_ready_skill(image);
 }
 
@@ -562,7 +598,7 @@ bool asst::BattleHelper::use_all_ready_skill(const cv::Mat& reusable)
     static constexpr auto min_frame_interval = std::chrono::milliseconds(1000);
 
     bool used = false;
-    cv::Mat image = reusable.empty() ? m_inst_helper.ctrler()->get_image() : reusable;
+    cv::Mat image = reusable.empty() ? get_tracked_image() : reusable;
     for (const auto& [name, loc] : m_battlefield_opers) {
         auto& usage = m_skill_usage[name];
         auto& retry = m_skill_error_count[name];
@@ -629,7 +665,7 @@ bool asst::BattleHelper::check_and_use_skill(
     bool& has_error,
     const cv::Mat& reusable)
 {
-    cv::Mat image = reusable.empty() ? m_inst_helper.ctrler()->get_image() : reusable;
+    cv::Mat image = reusable.empty() ? get_tracked_image() : reusable;
     BattlefieldClassifier skill_analyzer(image);
     skill_analyzer.set_object_of_interest({ .skill_ready = true });
 
@@ -905,6 +941,20 @@ std::string asst::BattleHelper::analyze_detail_page_oper_name(const cv::Mat& ima
     return BattleData.is_name_invalid(det_name) ? std::string() : det_name;
 }
 
+cv::Mat asst::BattleHelper::get_tracked_image()
+{
+    m_tracked_image = m_inst_helper.ctrler()->get_image(m_tracked_frame);
+    return m_tracked_image;
+}
+
+asst::TileChangeTracker::FrameRef asst::BattleHelper::get_frame_ref(const cv::Mat& image) const
+{
+    if (image.empty() || image.data != m_tracked_image.data) {
+        return {};
+    }
+    return m_tracked_frame;
+}
+
 std::optional<asst::Rect>
     asst::BattleHelper::get_oper_rect_on_deployment(const std::string& name) const
 {
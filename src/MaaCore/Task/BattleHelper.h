@@ -8,6 +8,7 @@
 #include "Utils/NoWarningCVMat.h"
 #include "Utils/Platform.hpp"
 #include "Utils/WorkingDir.hpp"
+#include "Vision/TileChangeTracker.h"
 
 #include <filesystem>
 #include <map>
@@ -71,6 +72,10 @@ namespace asst
 
         std::optional<Rect> get_oper_rect_on_deployment(const std::string& name) const;
 
+        // 截图并记下这一帧，之后对这张图（包括作为 reusable 传回来时）的识别可以复用画面没有变化区域的结果
+        cv::Mat get_tracked_image();
+        TileChangeTracker::FrameRef get_frame_ref(const cv::Mat& image) const;
+
         std::string m_stage_name;
         Map::Level m_map_data;
         std::unordered_map<Point, TilePack::TileInfo> m_side_tile_info;   // 子弹时间的坐标映射
@@ -97,5 +102,7 @@ namespace asst
 
     private:
         InstHelper m_inst_helper;
+        cv::Mat m_tracked_image; // 持有引用，保证 data 指针在比较期间不会被其他图像复用
+        TileChangeTracker::FrameRef m_tracked_frame;
     };
 } // namespace asst
@@ -288,13 +288,13 @@ bool asst::BattleProcessTask::wait_condition(const Action& action)
     cv::Mat image;
     auto update_image_if_empty = [&]() {
         if (image.empty()) {
-            image = ctrler()->get_image();
+            image = get_tracked_image();
             check_in_battle(image);
         }
     };
     auto do_strategy_and_update_image = [&]() {
         do_strategic_action(image);
-        image = ctrler()->get_image();
+        image = get_tracked_image();
     };
 
     if (action.cost_changes != 0) {
@@ -411,10 +411,11 @@ bool asst::BattleProcessTask::check_in_battle(const cv::Mat& reusable, bool weak
 {
     LogTraceFunction;
 
-    cv::Mat image = reusable.empty() ? ctrler()->get_image() : reusable;
+    cv::Mat image = reusable.empty() ? get_tracked_image() : reusable;
 
     if (weak) {
         BattlefieldMatcher analyzer(image);
+        analyzer.set_frame_ref(get_frame_ref(image));
         auto result = analyzer.analyze();
         m_in_battle = result.has_value();
         if (m_in_battle && !result->pause_button) {
@@ -124,13 +124,28 @@ bool ProcessTask::_run()
             m_cur_task_ptr = front_task_ptr;
         }
         else {
-            cv::Mat image = m_reusable.empty() ? ctrler()->get_image() : m_reusable;
+            // 画面没变、期间也没有任何操作，识别结果必然和上次一样，例如等待加载界面的时候
+            // stamp 要和图像一起取，否则预取的下一帧可能已经更新了它，记下的就不是分析过的那一帧
+            Controller::FrameStamp stamp;
+            cv::Mat image = m_reusable.empty() ? ctrler()->get_image(stamp) : m_reusable;
             m_reusable = cv::Mat();
+
+            if (stamp.valid() && m_last_missed && m_last_missed->stamp == stamp
+                && m_last_missed->tasks_name == m_cur_task_name_list) {
+                Log.trace("screen unchanged since last analysis, skip");
+                return false;
+            }
+
             PipelineAnalyzer analyzer(image, Rect(), m_inst);
             analyzer.set_tasks(m_cur_task_name_list);
 
             auto res_opt = analyzer.analyze();
+            // 只缓存未命中的结果：命中后会执行动作、触发回调（插件可能会修改任务参数），缓存都会失效
+            m_last_missed.reset();
             if (!res_opt) {
+                if (stamp.valid()) {
+                    m_last_missed = MissedAnalysis { .stamp = stamp, .tasks_name = m_cur_task_name_list };
+                }
                 return false;
             }
             m_cur_task_ptr = res_opt->task_ptr;
@@ -2,6 +2,7 @@
 
 #include "AbstractTask.h"
 #include "Common/AsstTypes.h"
+#include "Controller/Controller.h"
 #include "Utils/NoWarningCVMat.h"
 
 namespace asst
@@ -62,5 +63,13 @@ namespace asst
         static constexpr int TaskDelayUnsetted = -1;
         int m_task_delay = TaskDelayUnsetted;
         cv::Mat m_reusable;
+
+        // 上一次没有识别到任何任务时的画面和任务列表，两者都没变时直接复用这个结果，不再重新识别
+        struct MissedAnalysis
+        {
+            Controller::FrameStamp stamp;
+            std::vector<std::string> tasks_name;
+        };
+        std::optional<MissedAnalysis> m_last_missed;
     };
 }
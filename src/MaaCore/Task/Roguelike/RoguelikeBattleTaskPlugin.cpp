@@ -482,7 +482,7 @@ bool asst::RoguelikeBattleTaskPlugin::do_once()
         std::this_thread::sleep_for(min_frame_interval - (now - prev_frame_time));
     }
 
-    cv::Mat image = ctrler()->get_image();
+    cv::Mat image = get_tracked_image();
     prev_frame_time = std::chrono::steady_clock::now();
 
     if (!m_first_deploy) {
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "SingletonHolder.hpp"
+
+namespace asst
+{
+    // 进程内共享的识别线程池，MaaCore 自己的并行识别、OpenCV 的并行循环都跑在这上面，多开时也不会超额订阅
+    // 线程在第一次提交任务时才创建；提交进来的任务不要再去等池里的其他任务，线程都占满的时候会死锁
+    // 需要等结果的并行循环请用 parallel_for，调用的线程自己也会参与执行，嵌套调用也没问题
+    class WorkerPool final : public SingletonHolder<WorkerPool>
+    {
+        friend class SingletonHolder<WorkerPool>;
+
+    public:
+        virtual ~WorkerPool() override { stop_threads(); }
+
+        // 池里的线程数，不包括调用 parallel_for 的线程
+        size_t size() const noexcept { return m_size; }
+        // 0 为自动（CPU 核数的一半）。正在执行的任务会先做完，排队的任务换到新的线程上
+        // 不要在池里的线程上调用，它会等池里的线程全部退出
+        void set_size(size_t size)
+        {
+            if (size == 0) {
+                size = default_size();
+            }
+            std::unique_lock<std::mutex> resize_lock(m_resize_mutex);
+            if (size == m_size) {
+                return;
+            }
+            // 换线程期间 post 进来的任务只排队，等新的线程起来再做
+            stop_threads();
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_exit = false;
+            m_size = size;
+            if (!m_jobs.empty()) {
+                start_threads();
+            }
+        }
+
+        // 当前线程在池里的序号，从 1 开始；不是池里的线程时为 0
+        static size_t thread_index() noexcept { return t_thread_index; }
+
+        template <typename FuncT>
+        auto submit(FuncT&& func) -> std::future<std::invoke_result_t<std::decay_t<FuncT>>>
+        {
+            using ResultT = std::invoke_result_t<std::decay_t<FuncT>>;
+            auto task = std::make_shared<std::packaged_task<ResultT()>>(std::forward<FuncT>(func));
+            auto future = task->get_future();
+            post([task]() { (*task)(); });
+            return future;
+        }
+
+        // 并行执行 func(0) ... func(count - 1)，下标按从小到大的顺序领取，全部执行完才返回
+        // 任意一次调用抛出异常时，还没领取的下标不再执行，异常在当前线程上重新抛出
+        template <typename FuncT>
+        void parallel_for(size_t count, FuncT&& func)
+        {
+            const size_t helpers = count == 0 ? 0 : (std::min)(size(), count - 1);
+            if (helpers == 0) {
+                for (size_t i = 0; i < count; ++i) {
+                    func(i);
+                }
+                return;
+            }
+
+            struct State
+            {
+                std::atomic_size_t next = 0;
+                std::mutex mutex;
+                std::condition_variable cv;
+                size_t running = 0;
+                bool closed = false;
+                std::exception_ptr error;
+            };
+            auto state = std::make_shared<State>();
+
+            auto work = [state, count, &func]() {
+                try {
+                    for (size_t index = state->next++; index < count; index = state->next++) {
+                        func(index);
+                    }
+                }
+                catch (...) {
+                    state->next = count;
+                    std::unique_lock<std::mutex> lock(state->mutex);
+                    if (!state->error) {
+                        state->error = std::current_exception();
+                    }
+                }
+            };
+
+            for (size_t i = 0; i < helpers; ++i) {
+                post([state, work]() {
+                    {
+                        std::unique_lock<std::mutex> lock(state->mutex);
+                        // 调用的线程已经做完返回了，还没开始的直接丢掉，func 也不能再用了
+                        if (state->closed) {
+                            return;
+                        }
+                        ++state->running;
+                    }
+                    work();
+                    std::unique_lock<std::mutex> lock(state->mutex);
+                    --state->running;
+                    state->cv.notify_all();
+                });
+            }
+
+            work();
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->closed = true;
+            // 只等已经开始执行的，没开始的不用等，所以不会因为池被占满而卡住
+            state->cv.wait(lock, [&]() { return state->running == 0; });
+            if (state->error) {
+                std::rethrow_exception(state->error);
+            }
+        }
+
+    private:
+        WorkerPool() : m_size(default_size()) {}
+
+        static size_t default_size() noexcept { return (std::max)(1U, std::thread::hardware_concurrency() / 2); }
+
+        void post(std::function<void()> job)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                // m_exit 时正在换线程或者正在析构，不能再起新的线程
+                if (m_threads.empty() && !m_exit) {
+                    start_threads();
+                }
+                m_jobs.emplace_back(std::move(job));
+            }
+            m_cv.notify_one();
+        }
+
+        // 需要持有 m_mutex
+        void start_threads()
+        {
+            for (size_t i = 0; i < m_size; ++i) {
+                m_threads.emplace_back(&WorkerPool::working_proc, this, i + 1);
+            }
+        }
+
+        // 之后 m_exit 保持为 true，需要的话由调用者持有 m_mutex 恢复
+        void stop_threads()
+        {
+            std::vector<std::thread> threads;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_exit = true;
+                threads.swap(m_threads);
+            }
+            m_cv.notify_all();
+            for (std::thread& thread : threads) {
+                if (thread.joinable()) {
+                    thread.join();
+                }
+            }
+        }
+
+        void working_proc(size_t index)
+        {
+            t_thread_index = index;
+            while (true) {
+                std::function<void()> job;
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_cv.wait(lock, [&]() { return m_exit || !m_jobs.empty(); });
+                    if (m_exit) {
+                        return;
+                    }
+                    job = std::move(m_jobs.front());
+                    m_jobs.pop_front();
+                }
+                job();
+            }
+        }
+
+        inline static thread_local size_t t_thread_index = 0;
+
+        std::atomic_size_t m_size = 1;
+        bool m_exit = false;
+        std::mutex m_resize_mutex; // 同一时间只有一个 set_size 在换线程
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::deque<std::function<void()>> m_jobs;
+        std::vector<std::thread> m_threads;
+    };
+} // namespace asst
@@ -0,0 +1,205 @@
+#include "BatchTemplMatcher.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <map>
+
+#include "Utils/NoWarningCV.h"
+#include "Utils/WorkerPool.hpp"
+
+using namespace asst;
+
+BatchTemplMatcher::BatchTemplMatcher(const cv::Mat& image) : m_image(image)
+{
+    m_image.convertTo(m_image_f, CV_MAKETYPE(CV_32F, m_image.channels()));
+    cv::integral(m_image, m_sum, m_sqsum, CV_64F, CV_64F);
+}
+
+std::vector<cv::Mat> BatchTemplMatcher::match(const std::vector<cv::Mat>& templs)
+{
+    std::vector<cv::Mat> results(templs.size());
+
+    // 按尺寸分组，同尺寸的模板共享窗口统计量
+    std::map<std::pair<int, int>, std::vector<size_t>> groups;
+    for (size_t i = 0; i < templs.size(); ++i) {
+        const cv::Mat& templ = templs[i];
+        if (templ.empty() || templ.type() != m_image.type() || templ.cols > m_image.cols ||
+            templ.rows > m_image.rows) {
+            continue;
+        }
+        groups[{ templ.cols, templ.rows }].emplace_back(i);
+    }
+
+    for (const auto& [size, indices] : groups) {
+        match_group(cv::Size(size.first, size.second), templs, indices, results);
+    }
+    return results;
+}
+
+void BatchTemplMatcher::match_group(const cv::Size& templ_size, const std::vector<cv::Mat>& templs,
+                                    const std::vector<size_t>& indices, std::vector<cv::Mat>& results)
+{
+    const double area = templ_size.area();
+    const int cn = m_image.channels();
+
+    // 模板减去各通道的均值之后，和原图窗口的相关就是 CCOEFF 的分子
+    std::vector<cv::Mat> templs_zm;
+    std::vector<double> templ_norms;
+    templs_zm.reserve(indices.size());
+    templ_norms.reserve(indices.size());
+    for (size_t index : indices) {
+        cv::Mat templ_f;
+        templs[index].convertTo(templ_f, CV_MAKETYPE(CV_32F, cn));
+        cv::subtract(templ_f, cv::mean(templs[index]), templ_f);
+        templ_norms.emplace_back(cv::norm(templ_f, cv::NORM_L2));
+        templs_zm.emplace_back(std::move(templ_f));
+    }
+
+    // 粗略估计两种算法的开销，选便宜的那个。GEMM 的开销正好是窗口矩阵的大小，太大了内存吃不消
+    const cv::Size result_size(m_image.cols - templ_size.width + 1, m_image.rows - templ_size.height + 1);
+    const double gemm_cost = static_cast<double>(result_size.area()) * area * cn;
+    const double dft_area = static_cast<double>(cv::getOptimalDFTSize(m_image.cols)) *
+                            cv::getOptimalDFTSize(m_image.rows);
+    const double dft_cost = dft_area * std::log2(dft_area) * (cn + 1);
+    const bool use_gemm = gemm_cost <= dft_cost && gemm_cost <= MaxGemmMatrixSize;
+    std::vector<cv::Mat> numerators =
+        use_gemm ? correlate_by_gemm(templ_size, templs_zm) : correlate_by_dft(templ_size, templs_zm);
+
+    // 归一化的方式和 OpenCV 的 common_matchTemplate 保持一致
+    const cv::Mat wnd_var = window_variance(templ_size);
+    for (size_t k = 0; k < indices.size(); ++k) {
+        cv::Mat& result = results[indices[k]];
+        if (templ_norms[k] * templ_norms[k] / area < DBL_EPSILON) {
+            // 纯色模板
+            result = cv::Mat(result_size, CV_32F, cv::Scalar(1));
+            continue;
+        }
+        result.create(result_size, CV_32F);
+        const cv::Mat& numerator = numerators[k];
+        for (int y = 0; y < result_size.height; ++y) {
+            const float* num_row = numerator.ptr<float>(y);
+            const double* var_row = wnd_var.ptr<double>(y);
+            float* res_row = result.ptr<float>(y);
+            for (int x = 0; x < result_size.width; ++x) {
+                double num = num_row[x];
+                const double t = std::sqrt((std::max)(var_row[x], 0.0)) * templ_norms[k];
+                if (std::fabs(num) < t) {
+                    num /= t;
+                }
+                else if (std::fabs(num) < t * 1.125) {
+                    num = num > 0 ? 1 : -1;
+                }
+                else {
+                    num = 0;
+                }
+                res_row[x] = static_cast<float>(num);
+            }
+        }
+    }
+}
+
+cv::Mat BatchTemplMatcher::window_variance(const cv::Size& templ_size)
+{
+    const int cn = m_image.channels();
+    const double inv_area = 1.0 / templ_size.area();
+    const cv::Size result_size(m_image.cols - templ_size.width + 1, m_image.rows - templ_size.height + 1);
+
+    cv::Mat wnd_var(result_size, CV_64F);
+    for (int y = 0; y < result_size.height; ++y) {
+        const double* sum_top = m_sum.ptr<double>(y);
+        const double* sum_bottom = m_sum.ptr<double>(y + templ_size.height);
+        const double* sq_top = m_sqsum.ptr<double>(y);
+        const double* sq_bottom = m_sqsum.ptr<double>(y + templ_size.height);
+        double* var_row = wnd_var.ptr<double>(y);
+        for (int x = 0; x < result_size.width; ++x) {
+            const int l = x * cn;
+            const int r = (x + templ_size.width) * cn;
+            double var = 0;
+            for (int c = 0; c < cn; ++c) {
+                const double s = sum_bottom[r + c] - sum_bottom[l + c] - sum_top[r + c] + sum_top[l + c];
+                const double sq = sq_bottom[r + c] - sq_bottom[l + c] - sq_top[r + c] + sq_top[l + c];
+                var += sq - s * s * inv_area;
+            }
+            var_row[x] = var;
+        }
+    }
+    return wnd_var;
+}
+
+std::vector<cv::Mat> BatchTemplMatcher::correlate_by_gemm(const cv::Size& templ_size,
+                                                          const std::vector<cv::Mat>& templs_zm)
+{
+    const int cn = m_image.channels();
+    const int dims = templ_size.area() * cn;
+    const cv::Size result_size(m_image.cols - templ_size.width + 1, m_image.rows - templ_size.height + 1);
+
+    // 每一行是一个窗口（或一个模板）展开后的像素
+    cv::Mat windows(result_size.area(), dims, CV_32F);
+    for (int y = 0; y < result_size.height; ++y) {
+        for (int x = 0; x < result_size.width; ++x) {
+            cv::Mat row(templ_size, m_image_f.type(), windows.ptr<float>(y * result_size.width + x));
+            m_image_f(cv::Rect(cv::Point(x, y), templ_size)).copyTo(row);
+        }
+    }
+    cv::Mat templ_rows(static_cast<int>(templs_zm.size()), dims, CV_32F);
+    for (size_t k = 0; k < templs_zm.size(); ++k) {
+        cv::Mat row(templ_size, m_image_f.type(), templ_rows.ptr<float>(static_cast<int>(k)));
+        templs_zm[k].copyTo(row);
+    }
+
+    // windows.rows x templs.size()，第 k 列是第 k 个模板在所有窗口上的相关
+    cv::Mat product;
+    cv::gemm(windows, templ_rows, 1.0, cv::noArray(), 0.0, product, cv::GEMM_2_T);
+
+    std::vector<cv::Mat> numerators;
+    numerators.reserve(templs_zm.size());
+    for (int k = 0; k < product.cols; ++k) {
+        numerators.emplace_back(product.col(k).clone().reshape(1, result_size.height));
+    }
+    return numerators;
+}
+
+std::vector<cv::Mat> BatchTemplMatcher::correlate_by_dft(const cv::Size& templ_size,
+                                                         const std::vector<cv::Mat>& templs_zm)
+{
+    const int cn = m_image.channels();
+
+    // 结果只取不会绕回的部分，所以 DFT 的尺寸不小于原图即可
+    if (m_image_spectrums.empty()) {
+        m_dft_size = cv::Size(cv::getOptimalDFTSize(m_image.cols), cv::getOptimalDFTSize(m_image.rows));
+        std::vector<cv::Mat> channels;
+        cv::split(m_image_f, channels);
+        for (const cv::Mat& channel : channels) {
+            cv::Mat padded = cv::Mat::zeros(m_dft_size, CV_32F);
+            channel.copyTo(padded(cv::Rect(0, 0, channel.cols, channel.rows)));
+            cv::Mat spectrum;
+            cv::dft(padded, spectrum, 0, channel.rows);
+            m_image_spectrums.emplace_back(std::move(spectrum));
+        }
+    }
+
+    const cv::Rect result_rect(0, 0, m_image.cols - templ_size.width + 1, m_image.rows - templ_size.height + 1);
+    // 每个模板的 DFT 互不相关，分给各个线程做
+    std::vector<cv::Mat> numerators(templs_zm.size());
+    WorkerPool::get_instance().parallel_for(templs_zm.size(), [&](size_t k) {
+        const cv::Mat& templ = templs_zm[k];
+        std::vector<cv::Mat> channels;
+        cv::Mat padded, spectrum, product, accumulated;
+        cv::split(templ, channels);
+        // 频域是线性的，各通道的乘积先加起来，每个模板只需要一次逆变换
+        for (int c = 0; c < cn; ++c) {
+            padded = cv::Mat::zeros(m_dft_size, CV_32F);
+            channels[c].copyTo(padded(cv::Rect(0, 0, templ.cols, templ.rows)));
+            cv::dft(padded, spectrum, 0, templ.rows);
+            cv::mulSpectrums(m_image_spectrums[c], spectrum, c == 0 ? accumulated : product, 0, true);
+            if (c != 0) {
+                accumulated += product;
+            }
+        }
+        cv::Mat correlation;
+        cv::dft(accumulated, correlation, cv::DFT_INVERSE | cv::DFT_SCALE | cv::DFT_REAL_OUTPUT);
+        numerators[k] = correlation(result_rect).clone();
+    });
+    return numerators;
+}
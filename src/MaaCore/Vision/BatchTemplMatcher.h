@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+
+#include "Utils/NoWarningCVMat.h"
+
+namespace asst
+{
+    // 在同一张图上一次匹配多个模板，结果和逐个 cv::matchTemplate(TM_CCOEFF_NORMED) 一致（浮点误差内）
+    // 同尺寸的模板共享窗口的统计量；搜索范围大时在频域做相关，图像只做一次 DFT，
+    // 搜索范围很小时（例如头像和头像比）把所有窗口和模板展开成矩阵，一次 GEMM 算完
+    // 不支持掩码
+    class BatchTemplMatcher
+    {
+    public:
+        // image 和模板需要是同样的类型，一般是 CV_8UC3
+        explicit BatchTemplMatcher(const cv::Mat& image);
+        BatchTemplMatcher(const BatchTemplMatcher&) = delete;
+        BatchTemplMatcher(BatchTemplMatcher&&) = delete;
+        ~BatchTemplMatcher() = default;
+
+        // 返回和 templs 一一对应的结果（CV_32F），模板为空、比图像大或类型不一致时对应结果为空
+        std::vector<cv::Mat> match(const std::vector<cv::Mat>& templs);
+
+        BatchTemplMatcher& operator=(const BatchTemplMatcher&) = delete;
+        BatchTemplMatcher& operator=(BatchTemplMatcher&&) = delete;
+
+    private:
+        // 展开的窗口矩阵最多多少个 float（64 MB），再大就用 DFT，哪怕估计下来 GEMM 更快
+        static constexpr double MaxGemmMatrixSize = 16.0 * 1024 * 1024;
+
+        // 同尺寸的一组模板
+        void match_group(const cv::Size& templ_size, const std::vector<cv::Mat>& templs,
+                         const std::vector<size_t>& indices, std::vector<cv::Mat>& results);
+        // 每个窗口内 sum((I - mean(I))^2)，各通道求和
+        cv::Mat window_variance(const cv::Size& templ_size);
+        std::vector<cv::Mat> correlate_by_gemm(const cv::Size& templ_size, const std::vector<cv::Mat>& templs_zm);
+        std::vector<cv::Mat> correlate_by_dft(const cv::Size& templ_size, const std::vector<cv::Mat>& templs_zm);
+
+        cv::Mat m_image;
+        cv::Mat m_image_f; // CV_32FC(cn)
+        cv::Mat m_sum;     // 积分图
+        cv::Mat m_sqsum;   // 平方积分图
+        cv::Size m_dft_size;
+        std::vector<cv::Mat> m_image_spectrums; // 各通道的 DFT，第一次用到时才计算
+    };
+} // namespace asst
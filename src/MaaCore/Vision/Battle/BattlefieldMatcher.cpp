@@ -16,6 +16,14 @@
 
 using namespace asst;
 
+// OCR 会在二值化的外接矩形基础上再往外扩几个像素，缓存时 roi 也要算上
+static constexpr int OcrExpansionMargin = 4;
+
+static Rect expand_rect(const Rect& rect, int margin)
+{
+    return { rect.x - margin, rect.y - margin, rect.width + margin * 2, rect.height + margin * 2 };
+}
+
 void BattlefieldMatcher::set_object_of_interest(ObjectOfInterest obj)
 {
     m_object_of_interest = std::move(obj);
@@ -73,6 +81,8 @@ std::vector<battle::DeploymentOper> BattlefieldMatcher::deployment_analyze() con
     MultiMatcher flags_analyzer(m_image);
     const auto& flag_task_ptr = Task.get("BattleOpersFlag");
     flags_analyzer.set_task_info(flag_task_ptr);
+    flags_analyzer.set_frame_ref(m_frame);
+    flags_analyzer.set_image_context(image_context());
 
 #ifndef ASST_DEBUG
     flags_analyzer.set_log_tracing(false);
@@ -159,11 +169,16 @@ battle::Role BattlefieldMatcher::oper_role_analyze(const Rect& roi) const
 
     static const std::string TaskName = "BattleOperRole";
     static const std::string Ext = ".png";
+    if (auto cached = load_cached<battle::Role>(TaskName, roi)) {
+        return *cached;
+    }
+
     BestMatcher role_analyzer(m_image);
 #ifndef ASST_DEBUG
     role_analyzer.set_log_tracing(false);
 #endif // !ASST_DEBUG
     role_analyzer.set_task_info(TaskName);
+    role_analyzer.set_image_context(image_context());
     role_analyzer.set_roi(roi);
 
     for (const auto& role_name : RoleMap | views::keys) {
@@ -172,6 +187,7 @@ battle::Role BattlefieldMatcher::oper_role_analyze(const Rect& roi) const
     auto role_opt = role_analyzer.analyze();
     if (!role_opt) {
         Log.warn(__FUNCTION__, "unknown role");
+        store_cached(TaskName, roi, battle::Role::Unknown);
         return battle::Role::Unknown;
     }
 
@@ -183,7 +199,9 @@ battle::Role BattlefieldMatcher::oper_role_analyze(const Rect& roi) const
     cv::putText(m_image_draw, role_name, cv::Point(roi.x, roi.y - 5), 1, 1, cv::Scalar(0, 255, 255));
 #endif
 
-    return RoleMap.at(role_name);
+    battle::Role role = RoleMap.at(role_name);
+    store_cached(TaskName, roi, role);
+    return role;
 }
 
 bool BattlefieldMatcher::oper_cooling_analyze(const Rect& roi) const
@@ -210,6 +228,12 @@ bool BattlefieldMatcher::oper_cooling_analyze(const Rect& roi) const
 
 int BattlefieldMatcher::oper_cost_analyze(const Rect& roi) const
 {
+    static const std::string CacheKey = "BattleOperCost";
+    const Rect cache_roi = expand_rect(roi, OcrExpansionMargin);
+    if (auto cached = load_cached<int>(CacheKey, cache_roi)) {
+        return *cached;
+    }
+
     int cost = -1;
     RegionOCRer cost_analyzer(m_image, roi);
     cost_analyzer.set_replace(Task.get<OcrTaskInfo>("NumberOcrReplace")->replace_map);
@@ -223,6 +247,7 @@ int BattlefieldMatcher::oper_cost_analyze(const Rect& roi) const
         Log.warn("oper cost convert failed, str:", cost_analyzer.get_result().text);
         return cost;
     }
+    store_cached(CacheKey, cache_roi, cost);
     return cost;
 }
 
@@ -245,6 +270,8 @@ bool BattlefieldMatcher::hp_flag_analyze() const
     // 识别 HP 的那个蓝白色图标
     Matcher flag_analyzer(m_image);
     flag_analyzer.set_task_info("BattleHpFlag");
+    flag_analyzer.set_frame_ref(m_frame);
+    flag_analyzer.set_image_context(image_context());
     if (flag_analyzer.analyze()) {
         return true;
     }
@@ -258,10 +285,32 @@ bool BattlefieldMatcher::kills_flag_analyze() const
 {
     Matcher flag_analyzer(m_image);
     flag_analyzer.set_task_info("BattleKillsFlag");
+    flag_analyzer.set_frame_ref(m_frame);
+    flag_analyzer.set_image_context(image_context());
     return flag_analyzer.analyze().has_value();
 }
 
 std::optional<std::pair<int, int>> BattlefieldMatcher::kills_analyze() const
+{
+    // 识别时读取的区域：flag 的 roi，加上从 flag 移动到数字的范围
+    const Rect& flag_roi = Task.get("BattleKillsFlag")->roi;
+    const Rect& kills_move = Task.get<OcrTaskInfo>("BattleKills")->roi;
+    const int left = flag_roi.x + (std::min)(0, kills_move.x);
+    const int top = flag_roi.y + (std::min)(0, kills_move.y);
+    const int right = flag_roi.x + flag_roi.width + (std::max)(0, kills_move.x + kills_move.width);
+    const int bottom = flag_roi.y + flag_roi.height + (std::max)(0, kills_move.y + kills_move.height);
+    const Rect cache_roi = expand_rect({ left, top, right - left, bottom - top }, OcrExpansionMargin);
+    const std::string cache_key = "BattleKills|" + std::to_string(m_total_kills_prompt);
+    if (auto cached = load_cached<std::optional<std::pair<int, int>>>(cache_key, cache_roi)) {
+        return *cached;
+    }
+
+    auto kills = _kills_analyze();
+    store_cached(cache_key, cache_roi, kills);
+    return kills;
+}
+
+std::optional<std::pair<int, int>> BattlefieldMatcher::_kills_analyze() const
 {
     TemplDetOCRer kills_analyzer(m_image);
     kills_analyzer.set_task_info("BattleKillsFlag", "BattleKills");
@@ -321,6 +370,19 @@ std::optional<std::pair<int, int>> BattlefieldMatcher::kills_analyze() const
 }
 
 std::optional<int> BattlefieldMatcher::costs_analyze() const
+{
+    static const std::string TaskName = "BattleCostData";
+    const Rect cache_roi = expand_rect(Task.get(TaskName)->roi, OcrExpansionMargin);
+    if (auto cached = load_cached<std::optional<int>>(TaskName, cache_roi)) {
+        return *cached;
+    }
+
+    auto costs = _costs_analyze();
+    store_cached(TaskName, cache_roi, costs);
+    return costs;
+}
+
+std::optional<int> BattlefieldMatcher::_costs_analyze() const
 {
     RegionOCRer cost_analyzer(m_image);
     cost_analyzer.set_task_info("BattleCostData");
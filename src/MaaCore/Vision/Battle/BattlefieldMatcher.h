@@ -60,6 +60,10 @@ namespace asst
         bool in_detail_analyze() const;                           // 识别是否在详情页
         bool speed_button_analyze() const; // 识别是否有加速按钮（在详情页就没有）
 
+        // 不带缓存的版本
+        std::optional<std::pair<int, int>> _kills_analyze() const;
+        std::optional<int> _costs_analyze() const;
+
         ObjectOfInterest m_object_of_interest; // 待识别的目标
         int m_total_kills_prompt = 0; // 之前的击杀总数，因为击杀数经常识别不准所以依赖外部传入作为参考
     };
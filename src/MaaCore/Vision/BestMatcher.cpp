@@ -17,8 +17,13 @@ void BestMatcher::append_templ(std::string name, const cv::Mat& templ)
 
 BestMatcher::ResultOpt BestMatcher::analyze() const
 {
+    if (m_params.batch) {
+        return analyze_batch();
+    }
+
     Matcher match_analyzer(m_image, m_roi);
     match_analyzer.set_params(m_params);
+    match_analyzer.set_image_context(image_context());
 #ifdef ASST_DEBUG
     match_analyzer.set_log_tracing(m_log_tracing);
 #else
@@ -56,3 +61,56 @@ BestMatcher::ResultOpt BestMatcher::analyze() const
     m_result = std::move(result);
     return m_result;
 }
+
+BestMatcher::ResultOpt BestMatcher::analyze_batch() const
+{
+    if (m_templs.empty() || m_params.templ_thres.empty()) {
+        return std::nullopt;
+    }
+
+    // 所有模板共用同一套参数，一起交给 Matcher 批量匹配
+    auto params = m_params;
+    params.templs.clear();
+    for (const auto& templ_info : m_templs) {
+        if (templ_info.templ.empty()) {
+            params.templs.emplace_back(templ_info.name);
+        }
+        else {
+            params.templs.emplace_back(templ_info.templ);
+        }
+    }
+    const double threshold = m_params.templ_thres.front();
+    params.templ_thres.assign(m_templs.size(), threshold);
+    params.methods.assign(m_templs.size(), m_params.methods.empty() ? MatchMethod::Ccoeff : m_params.methods.front());
+
+    const auto match_results = Matcher::preproc_and_match(*image_context(), m_roi, params);
+
+    Result result;
+    for (size_t i = 0; i < match_results.size(); ++i) {
+        const auto& [matched, templ, templ_name] = match_results[i];
+        if (matched.empty()) {
+            continue;
+        }
+
+        double max_val = 0.0;
+        cv::Point max_loc;
+        cv::minMaxLoc(matched, nullptr, &max_val, nullptr, &max_loc);
+        if (std::isnan(max_val) || std::isinf(max_val) || max_val < threshold) {
+            continue;
+        }
+        if (result.score < max_val) {
+            Rect rect(max_loc.x + m_roi.x, max_loc.y + m_roi.y, templ.cols, templ.rows);
+            result = Result { .rect = rect, .score = max_val, .templ_info = m_templs[i] };
+        }
+    }
+
+    if (!result.score) {
+        return std::nullopt;
+    }
+
+    if (m_log_tracing) {
+        Log.trace("The best match is", result.to_string(), result.templ_info.name);
+    }
+    m_result = std::move(result);
+    return m_result;
+}
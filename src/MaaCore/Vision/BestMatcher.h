@@ -45,6 +45,8 @@ namespace asst
     private:
         using MatcherConfig::set_templ;
 
+        ResultOpt analyze_batch() const;
+
         std::vector<TemplInfo> m_templs;
         // FIXME: 老接口太难重构了，先弄个这玩意兼容下，后续慢慢全删掉
         mutable Result m_result;
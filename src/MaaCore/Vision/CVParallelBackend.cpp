@@ -0,0 +1,42 @@
+#include "CVParallelBackend.h"
+
+#include <mutex>
+
+#include "Utils/Logger.hpp"
+#include "Utils/WorkerPool.hpp"
+
+using namespace asst;
+
+void CVParallelBackend::install()
+{
+    static std::once_flag once;
+    std::call_once(once, []() {
+        Log.info(__FUNCTION__, "| OpenCV parallel loops run on WorkerPool");
+        cv::parallel::setParallelForBackend(std::make_shared<CVParallelBackend>(), false);
+    });
+}
+
+void CVParallelBackend::parallel_for(int tasks, FN_parallel_for_body_cb_t body_callback, void* callback_data)
+{
+    WorkerPool::get_instance().parallel_for(static_cast<size_t>(tasks), [&](size_t index) {
+        const int stripe = static_cast<int>(index);
+        body_callback(stripe, stripe + 1, callback_data);
+    });
+}
+
+int CVParallelBackend::getThreadNum() const
+{
+    return static_cast<int>(WorkerPool::thread_index());
+}
+
+int CVParallelBackend::getNumThreads() const
+{
+    // 调用 parallel_for 的线程自己也会参与
+    return static_cast<int>(WorkerPool::get_instance().size()) + 1;
+}
+
+int CVParallelBackend::setNumThreads(int nThreads)
+{
+    std::ignore = nThreads;
+    return getNumThreads();
+}
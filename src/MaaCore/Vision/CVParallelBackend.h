@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Utils/NoWarningCV.h"
+ASST_SUPPRESS_CV_WARNINGS_START
+#include <opencv2/core/parallel/parallel_backend.hpp>
+ASST_SUPPRESS_CV_WARNINGS_END
+
+namespace asst
+{
+    // 让 OpenCV 的并行循环（cv::parallel_for_）跑在 WorkerPool 上，不再另开一组线程
+    // 线程数跟着 WorkerPool 走，cv::setNumThreads 不生效
+    class CVParallelBackend : public cv::parallel::ParallelForAPI
+    {
+    public:
+        // 重复调用只有第一次生效
+        static void install();
+
+    public:
+        virtual ~CVParallelBackend() override = default;
+
+        virtual void parallel_for(int tasks, FN_parallel_for_body_cb_t body_callback, void* callback_data) override;
+        virtual int getThreadNum() const override;
+        virtual int getNumThreads() const override;
+        virtual int setNumThreads(int nThreads) override;
+        virtual const char* getName() const override { return "MaaWorkerPool"; }
+    };
+}
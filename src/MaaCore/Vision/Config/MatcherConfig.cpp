@@ -64,6 +64,71 @@ void MatcherConfig::set_method(MatchMethod method) noexcept
     m_params.methods = { method };
 }
 
+void MatcherConfig::set_batch(bool batch) noexcept
+{
+    m_params.batch = batch;
+}
+
+void MatcherConfig::set_pyramid_level(int level) noexcept
+{
+    m_params.pyramid_level = level;
+}
+
+void MatcherConfig::set_prefilter(int max_diff) noexcept
+{
+    m_params.prefilter = max_diff;
+}
+
+void MatcherConfig::set_gray_first(bool gray_first) noexcept
+{
+    m_params.gray_first = gray_first;
+}
+
+std::optional<std::string> MatcherConfig::params_key() const
+{
+    std::string key;
+    for (const auto& templ : m_params.templs) {
+        if (!std::holds_alternative<std::string>(templ)) {
+            return std::nullopt;
+        }
+        key += std::get<std::string>(templ) + "|";
+    }
+    for (double thres : m_params.templ_thres) {
+        key += std::to_string(thres) + ",";
+    }
+    key += "|";
+    for (MatchMethod method : m_params.methods) {
+        key += std::to_string(static_cast<int>(method)) + ",";
+    }
+    key += "|";
+    key += ranges_key(m_params.mask_ranges);
+    key += m_params.mask_src ? "|src" : "|templ";
+    key += m_params.mask_close ? "|close|" : "|open|";
+    key += ranges_key(m_params.color_scales);
+    key += m_params.color_close ? "|close" : "|open";
+    key += "|" + std::to_string(m_params.pyramid_level);
+    key += "|" + std::to_string(m_params.prefilter);
+    key += m_params.gray_first ? "|gray" : "|rgb";
+    return key;
+}
+
+std::string MatcherConfig::ranges_key(const MatchTaskInfo::Ranges& range_list)
+{
+    std::string key;
+    for (const auto& range : range_list) {
+        if (const auto* gray = std::get_if<MatchTaskInfo::GrayRange>(&range)) {
+            key += std::to_string(gray->first) + "-" + std::to_string(gray->second) + ",";
+            continue;
+        }
+        const auto& [lower, upper] = std::get<MatchTaskInfo::ColorRange>(range);
+        for (size_t i = 0; i < lower.size(); ++i) {
+            key += std::to_string(lower[i]) + "-" + std::to_string(upper[i]) + ",";
+        }
+        key += ";";
+    }
+    return key;
+}
+
 void MatcherConfig::_set_task_info(MatchTaskInfo task_info)
 {
     m_params.templs.clear();
@@ -73,6 +138,10 @@ void MatcherConfig::_set_task_info(MatchTaskInfo task_info)
     m_params.color_scales = std::move(task_info.color_scales);
     m_params.color_close = task_info.color_close;
     m_params.methods = std::move(task_info.methods);
+    m_params.batch = task_info.batch_match;
+    m_params.pyramid_level = task_info.pyramid_level;
+    m_params.prefilter = task_info.prefilter;
+    m_params.gray_first = task_info.gray_first;
 
     _set_roi(task_info.roi);
 }
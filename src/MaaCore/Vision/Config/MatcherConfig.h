@@ -3,6 +3,8 @@
 #include "Common/AsstTypes.h"
 #include "Utils/NoWarningCVMat.h"
 
+#include <optional>
+#include <string>
 #include <variant>
 
 namespace asst
@@ -20,6 +22,10 @@ namespace asst
             bool mask_close = false;            // 匹配时是否使用闭运算处理
             MatchTaskInfo::Ranges color_scales; // 数色时的颜色掩码范围
             bool color_close = true;            // 数色时是否使用闭运算处理
+            bool batch = false;                 // 多个模板一起匹配，只对不带掩码的 Ccoeff 生效，结果不变
+            int pyramid_level = 0; // 先在 1/2^level 的缩小图上找候选位置，再在原图上细化。0 为不使用
+            int prefilter = 0; // 没有任何窗口的平均颜色和模板相差在该值以内时直接跳过匹配。0 为不使用
+            bool gray_first = false; // 先在灰度图上找候选位置，再用彩色图算得分，只对不带掩码的 Ccoeff 生效
         };
 
     public:
@@ -39,6 +45,15 @@ namespace asst
         void set_mask_ranges(MatchTaskInfo::Ranges mask_ranges, bool mask_src = false, bool mask_close = false);
         void set_color_scales(MatchTaskInfo::Ranges color_scales, bool color_close = true);
         void set_method(MatchMethod method) noexcept;
+        void set_batch(bool batch) noexcept;
+        void set_pyramid_level(int level) noexcept;
+        void set_prefilter(int max_diff) noexcept;
+        void set_gray_first(bool gray_first) noexcept;
+
+        // 唯一描述当前参数的字符串，用于缓存识别结果。模板是 cv::Mat 的无法描述，返回 nullopt
+        std::optional<std::string> params_key() const;
+        // 唯一描述一组颜色范围的字符串
+        static std::string ranges_key(const MatchTaskInfo::Ranges& range_list);
 
     protected:
         virtual void _set_roi(const Rect& roi) = 0;
@@ -10,16 +10,11 @@ void OCRerConfig::set_params(Params params)
     m_params = std::move(params);
 }
 
-void OCRerConfig::set_required(std::vector<std::string> required) noexcept
+void OCRerConfig::set_required(const std::vector<std::string>& required, const std::string& cache_key) noexcept
 {
-    m_params.required.clear();
-    m_params.required.reserve(required.size());
-
-    auto& ocr_config = OcrConfig::get_instance();
-    for (auto& str : required) {
-        std::string equ_str = ocr_config.process_equivalence_class(str);
-        m_params.required.emplace_back(std::move(str), std::move(equ_str));
-    }
+    // 归一化的结果在 OcrConfig 里按 cache_key 缓存，同一个任务不用每次都重新算
+    auto equ_required = OcrConfig::get_instance().get_required(required, cache_key);
+    m_params.required = *equ_required;
 }
 
 void OCRerConfig::set_replace(const std::vector<std::pair<std::string, std::string>>& replace,
@@ -28,24 +23,15 @@ void OCRerConfig::set_replace(const std::vector<std::pair<std::string, std::stri
     m_params.replace.clear();
     m_params.replace.reserve(replace.size());
 
+    // 正则在 OcrConfig 里按 key 缓存，同样的 replace 只编译一次
+    auto& ocr_config = OcrConfig::get_instance();
     for (auto&& [key, val] : replace) {
-        auto& ocr_config = OcrConfig::get_instance();
-        std::string new_key = key;
-        for (const auto& eq_class : ocr_config.get_eq_classes()) {
-            if (eq_class.size() <= 1) continue;
-
-            // eq_class: [s, S] -> regex: "(?:s|S)"
-            std::string eq_classes_regex = "(?:";
-            for (const auto& elem : eq_class)
-                (eq_classes_regex += elem) += '|';
-            eq_classes_regex.pop_back();
-            eq_classes_regex += ')';
-            ranges::for_each(eq_class, [&](std::string_view elem) {
-                utils::string_replace_all_in_place(new_key, elem, eq_classes_regex);
-            });
+        auto regex = ocr_config.get_replace_regex(key);
+        if (!regex) {
+            continue;
         }
         // do not create new_val as val is user-provided, and can avoid issues like 夕 and katakana タ
-        m_params.replace.emplace_back(std::move(new_key), val);
+        m_params.replace.emplace_back(std::move(regex), val);
     }
     m_params.replace_full = replace_full;
 }
@@ -70,6 +56,11 @@ void OCRerConfig::set_use_char_model(bool enable) noexcept
     m_params.use_char_model = enable;
 }
 
+void OCRerConfig::set_use_cache(bool enable) noexcept
+{
+    m_params.use_cache = enable;
+}
+
 void OCRerConfig::set_bin_threshold(int lower, int upper)
 {
     m_params.bin_threshold_lower = lower;
@@ -89,11 +80,12 @@ void asst::OCRerConfig::set_bin_trim_threshold(int left, int right)
 
 void OCRerConfig::_set_task_info(OcrTaskInfo task_info)
 {
-    set_required(std::move(task_info.text));
+    set_required(task_info.text, task_info.name);
     m_params.full_match = task_info.full_match;
     set_replace(task_info.replace_map, task_info.replace_full);
     m_params.use_char_model = task_info.is_ascii;
     m_params.without_det = task_info.without_det;
+    m_params.use_cache = task_info.use_cache;
 
     _set_roi(task_info.roi);
 }
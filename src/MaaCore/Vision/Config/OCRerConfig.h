@@ -3,6 +3,8 @@
 #include "Common/AsstTypes.h"
 #include "Utils/NoWarningCVMat.h"
 
+#include <memory>
+#include <regex>
 #include <variant>
 
 namespace asst
@@ -14,10 +16,11 @@ namespace asst
         {
             std::vector<std::pair<std::string, std::string>> required; // raw, equivalent
             bool full_match = false;
-            std::vector<std::pair<std::string, std::string>> replace;
+            std::vector<std::pair<std::shared_ptr<const std::regex>, std::string>> replace; // 正则, 替换后的文字
             bool replace_full = false;
             bool without_det = false;
             bool use_char_model = false;
+            bool use_cache = false; // 像素完全相同的图直接用上次的识别结果
 
             int bin_threshold_lower = 140;
             int bin_threshold_upper = 255;
@@ -32,7 +35,9 @@ namespace asst
 
         void set_params(Params params);
 
-        void set_required(std::vector<std::string> required) noexcept;
+        // cache_key 非空时按它缓存等价类归一化的结果，一般传任务名
+        void set_required(const std::vector<std::string>& required,
+                          const std::string& cache_key = std::string()) noexcept;
         void set_replace(const std::vector<std::pair<std::string, std::string>>& replace,
                          bool replace_full = false) noexcept;
 
@@ -41,6 +46,7 @@ namespace asst
 
         void set_without_det(bool without_det) noexcept;
         void set_use_char_model(bool enable) noexcept;
+        void set_use_cache(bool enable) noexcept;
 
         void set_bin_threshold(int lower, int upper = 255);
         void set_bin_expansion(int expansion);
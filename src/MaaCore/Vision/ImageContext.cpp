@@ -0,0 +1,65 @@
+#include "ImageContext.h"
+
+#include <algorithm>
+
+#include "Utils/NoWarningCV.h"
+
+using namespace asst;
+
+ImageContext::ImageContext(const cv::Mat& image) : m_image(image) {}
+
+bool ImageContext::is_of(const cv::Mat& image) const noexcept
+{
+    return m_image.data == image.data && m_image.size() == image.size() && m_image.type() == image.type() &&
+           m_image.step == image.step;
+}
+
+cv::Mat ImageContext::rgb(const Rect& roi) const
+{
+    return get(m_rgb, cv::COLOR_BGR2RGB, CV_8UC3, roi);
+}
+
+cv::Mat ImageContext::gray(const Rect& roi) const
+{
+    return get(m_gray, cv::COLOR_BGR2GRAY, CV_8UC1, roi);
+}
+
+cv::Mat ImageContext::hsv(const Rect& roi) const
+{
+    return get(m_hsv, cv::COLOR_BGR2HSV, CV_8UC3, roi);
+}
+
+cv::Mat ImageContext::get(Plane& plane, int code, int type, const Rect& roi) const
+{
+    const cv::Rect full(0, 0, m_image.cols, m_image.rows);
+    const cv::Rect area = roi.empty() ? full : (make_rect<cv::Rect>(roi) & full);
+    if (area.empty()) {
+        return {};
+    }
+
+    std::unique_lock<std::mutex> lock(plane.mutex);
+    if (plane.mat.empty()) {
+        plane.mat.create(m_image.size(), type);
+        plane.converted.assign((m_image.rows + BandHeight - 1) / BandHeight, 0);
+    }
+
+    // 连续的几个没转换过的 band 合在一起转换，少调用几次 cvtColor
+    const int band_end = (area.y + area.height - 1) / BandHeight + 1;
+    for (int band = area.y / BandHeight; band < band_end;) {
+        if (plane.converted[band]) {
+            ++band;
+            continue;
+        }
+        int last = band;
+        while (last < band_end && !plane.converted[last]) {
+            plane.converted[last] = 1;
+            ++last;
+        }
+        const cv::Range rows(band * BandHeight, (std::min)(m_image.rows, last * BandHeight));
+        cv::Mat dst = plane.mat.rowRange(rows);
+        cv::cvtColor(m_image.rowRange(rows), dst, code);
+        band = last;
+    }
+    // 其他线程之后只会写别的行，这里返回的视图不需要再加锁
+    return plane.mat(area);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include "Common/AsstTypes.h"
+#include "Utils/NoWarningCVMat.h"
+
+namespace asst
+{
+    // 一帧 BGR 图像的颜色转换缓存，同一帧上的多个分析器共享，每种颜色空间最多只转换一次
+    // 按需转换：只转换 roi 覆盖到的行（以 BandHeight 行为单位），返回的是整帧结果上的 roi 视图
+    class ImageContext
+    {
+    public:
+        static constexpr int BandHeight = 32;
+
+    public:
+        explicit ImageContext(const cv::Mat& image);
+        ImageContext(const ImageContext&) = delete;
+        ImageContext(ImageContext&&) = delete;
+        ~ImageContext() = default;
+
+        const cv::Mat& image() const noexcept { return m_image; }
+        // 是否就是 image 这张图（同一块内存、同样大小），而不只是内容相同
+        bool is_of(const cv::Mat& image) const noexcept;
+
+        // roi 为空时返回整张图
+        cv::Mat rgb(const Rect& roi = Rect()) const;
+        cv::Mat gray(const Rect& roi = Rect()) const;
+        cv::Mat hsv(const Rect& roi = Rect()) const;
+
+        ImageContext& operator=(const ImageContext&) = delete;
+        ImageContext& operator=(ImageContext&&) = delete;
+
+    private:
+        struct Plane
+        {
+            std::mutex mutex;
+            cv::Mat mat;
+            std::vector<uint8_t> converted; // 每个 band 是否已经转换过
+        };
+
+        cv::Mat get(Plane& plane, int code, int type, const Rect& roi) const;
+
+        cv::Mat m_image;
+        mutable Plane m_rgb;
+        mutable Plane m_gray;
+        mutable Plane m_hsv;
+    };
+} // namespace asst
@@ -1,17 +1,45 @@
 #include "Matcher.h"
 
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <unordered_map>
+
 #include "Utils/NoWarningCV.h"
 
 #include "Config/TaskData.h"
 #include "Config/TemplResource.h"
 #include "Utils/Logger.hpp"
 #include "Utils/StringMisc.hpp"
+#include "Vision/BatchTemplMatcher.h"
 
 using namespace asst;
 
 Matcher::ResultOpt Matcher::analyze() const
 {
-    const auto match_results = preproc_and_match(make_roi(m_image, m_roi), m_params);
+    // 画面在 roi 内没有变化时，直接用上次的结果
+    const auto cache_key = m_frame ? params_key() : std::nullopt;
+    if (cache_key) {
+        if (auto cached = load_cached<ResultOpt>("Matcher|" + *cache_key, m_roi)) {
+            if (*cached) {
+                // FIXME: 老接口太难重构了，先弄个这玩意兼容下，后续慢慢全删掉
+                m_result = **cached;
+            }
+            return *cached;
+        }
+    }
+
+    auto result = _analyze();
+    // 中途放弃的结果不完整，不能缓存
+    if (cache_key && !stop_requested()) {
+        store_cached("Matcher|" + *cache_key, m_roi, result);
+    }
+    return result;
+}
+
+Matcher::ResultOpt Matcher::_analyze() const
+{
+    const auto match_results = preproc_and_match(*image_context(), m_roi, m_params, m_stop_predicate);
 
     for (size_t i = 0; i < match_results.size(); ++i) {
         const auto& [matched, templ, templ_name] = match_results[i];
@@ -51,10 +79,24 @@ Matcher::ResultOpt Matcher::analyze() const
     return std::nullopt;
 }
 
-std::vector<Matcher::RawResult> Matcher::preproc_and_match(const cv::Mat& image, const MatcherConfig::Params& params)
+std::vector<Matcher::RawResult> Matcher::preproc_and_match(
+    const ImageContext& context,
+    const Rect& roi,
+    const MatcherConfig::Params& params,
+    const std::function<bool()>& stop)
 {
+    const cv::Mat image = make_roi(context.image(), roi);
+    // 搜索图的颜色转换在所有模板之间共享，用到时才转换
+    cv::Mat image_match, image_gray, image_hsv, image_small, image_sum;
+    // 批量匹配的模板先占位，最后一起算
+    std::vector<size_t> batch_indices;
+    std::vector<cv::Mat> batch_templs;
+
     std::vector<Matcher::RawResult> results;
     for (size_t i = 0; i != params.templs.size(); ++i) {
+        if (stop && stop()) {
+            return {};
+        }
         const auto& ptempl = params.templs[i];
         auto method = MatchMethod::Ccoeff;
         if (params.methods.size() <= i) {
@@ -64,9 +106,11 @@ std::vector<Matcher::RawResult> Matcher::preproc_and_match(const cv::Mat& image,
             method = params.methods[i];
         }
 
+        // 有问题的模板只跳过它自己，留一个空结果占位，结果和 params.templs 一一对应
         if (method == MatchMethod::Invalid) {
             Log.error(__FUNCTION__, "| invalid method");
-            return {};
+            results.emplace_back();
+            continue;
         }
 
         cv::Mat templ;
@@ -88,108 +132,469 @@ std::vector<Matcher::RawResult> Matcher::preproc_and_match(const cv::Mat& image,
 #ifdef ASST_DEBUG
             throw std::runtime_error("templ is empty: " + templ_name);
 #else
-            return {};
+            results.emplace_back(RawResult { .matched = cv::Mat(), .templ = templ, .templ_name = templ_name });
+            continue;
 #endif
         }
 
         if (templ.cols > image.cols || templ.rows > image.rows) {
             Log.error("templ size is too large", templ_name, "image size:", image.cols, image.rows,
                       "templ size:", templ.cols, templ.rows);
-            return {};
+            results.emplace_back(RawResult { .matched = cv::Mat(), .templ = templ, .templ_name = templ_name });
+            continue;
         }
 
-        cv::Mat matched;
-        cv::Mat image_match, image_count, image_gray;
-        cv::Mat templ_match, templ_count, templ_gray;
-        cv::cvtColor(image, image_match, cv::COLOR_BGR2RGB);
-        cv::cvtColor(templ, templ_match, cv::COLOR_BGR2RGB);
-        cv::cvtColor(image, image_gray, cv::COLOR_BGR2GRAY);
-        cv::cvtColor(templ, templ_gray, cv::COLOR_BGR2GRAY);
-        if (method == MatchMethod::HSVCount) {
-            cv::cvtColor(image, image_count, cv::COLOR_BGR2HSV);
-            cv::cvtColor(templ, templ_count, cv::COLOR_BGR2HSV);
-        }
-        else if (method == MatchMethod::RGBCount) {
-            image_count = image_match;
-            templ_count = templ_match;
+        // 只有资源里的模板才缓存，直接传进来的 cv::Mat 每次都重新处理
+        auto compiled = templ_name.empty() ? compile_templ(templ, templ_name, method, params)
+                                           : get_compiled_templ(templ, templ_name, method, params);
+        if (!compiled) {
+            results.emplace_back(RawResult { .matched = cv::Mat(), .templ = templ, .templ_name = templ_name });
+            continue;
         }
 
-        // 目前所有的匹配都是用 TM_CCOEFF_NORMED
-        int match_algorithm = cv::TM_CCOEFF_NORMED;
+        const bool is_count = method == MatchMethod::RGBCount || method == MatchMethod::HSVCount;
+        const bool gray_first = params.gray_first && method == MatchMethod::Ccoeff && params.mask_ranges.empty() &&
+                                compiled->templ_small.empty() && i < params.templ_thres.size();
+        const bool need_image_gray = (!params.mask_ranges.empty() && params.mask_src) || is_count || gray_first;
+        if (image_match.empty()) {
+            image_match = context.rgb(roi);
+        }
+        if (need_image_gray && image_gray.empty()) {
+            image_gray = context.gray(roi);
+        }
+        if (method == MatchMethod::HSVCount && image_hsv.empty()) {
+            image_hsv = context.hsv(roi);
+        }
 
-        auto calc_mask = [&templ_name](
-                             const MatchTaskInfo::Ranges mask_ranges,
-                             const cv::Mat& templ,
-                             const cv::Mat& templ_gray,
-                             bool with_close)
-            -> std::optional<cv::Mat> {
-            // Union all masks, not intersection
-            cv::Mat mask = cv::Mat::zeros(templ_gray.size(), CV_8UC1);
-            for (const auto& range : mask_ranges) {
-                cv::Mat current_mask;
-                if (std::holds_alternative<MatchTaskInfo::GrayRange>(range)) {
-                    const auto& gray_range = std::get<MatchTaskInfo::GrayRange>(range);
-                    cv::inRange(templ_gray, gray_range.first, gray_range.second, current_mask);
-                }
-                else if (std::holds_alternative<MatchTaskInfo::ColorRange>(range)) {
-                    const auto& color_range = std::get<MatchTaskInfo::ColorRange>(range);
-                    cv::inRange(templ, color_range.first, color_range.second, current_mask);
-                }
-                else {
-                    Log.error("The task with template", templ_name, "holds invalid mask range");
-                    return std::nullopt;
+        // 平均颜色都对不上的，不用再做模板匹配了
+        if (params.prefilter > 0 && params.mask_ranges.empty()) {
+            if (image_sum.empty()) {
+                cv::integral(image_match, image_sum, CV_32S);
+            }
+            const bool rejected = !prefilter_passed(image_sum, compiled->templ_mean, templ.size(), params.prefilter);
+            count_prefilter(templ_name, rejected);
+            if (rejected) {
+#ifdef ASST_DEBUG
+                // 确认没有把能匹配上的模板筛掉，方便调整阈值
+                cv::Mat expected;
+                double max_val = 0;
+                cv::matchTemplate(image_match, compiled->templ_match, expected, cv::TM_CCOEFF_NORMED);
+                cv::minMaxLoc(expected, nullptr, &max_val);
+                if (i < params.templ_thres.size() && max_val >= params.templ_thres[i]) {
+                    Log.warn(__FUNCTION__, "| prefilter rejected a match", templ_name, "score:", max_val);
                 }
-                cv::bitwise_or(mask, current_mask, mask);
+#endif
+                results.emplace_back(RawResult { .matched = cv::Mat(), .templ = templ, .templ_name = templ_name });
+                continue;
             }
+        }
 
-            if (with_close) {
-                cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(3, 3));
-                cv::morphologyEx(mask, mask, cv::MORPH_CLOSE, kernel);
+        if (!compiled->templ_small.empty() && i < params.templ_thres.size()) {
+            if (image_small.empty()) {
+                const double scale = 1.0 / (1 << params.pyramid_level);
+                cv::resize(image_match, image_small, cv::Size(), scale, scale, cv::INTER_AREA);
             }
-            return mask;
-        };
+            cv::Mat matched =
+                match_coarse_to_fine(image_match, image_small, *compiled, params.pyramid_level, params.templ_thres[i]);
+            results.emplace_back(RawResult { .matched = matched, .templ = templ, .templ_name = templ_name });
+            continue;
+        }
+
+        if (gray_first) {
+            cv::Mat matched = match_gray_first(image_match, image_gray, *compiled, params.templ_thres[i]);
+#ifdef ASST_DEBUG
+            // 和直接用彩色图匹配的结果对比，确认没有漏掉能匹配上的位置
+            cv::Mat expected;
+            double expected_max = 0, max_val = 0;
+            cv::matchTemplate(image_match, compiled->templ_match, expected, cv::TM_CCOEFF_NORMED);
+            cv::minMaxLoc(expected, nullptr, &expected_max);
+            cv::minMaxLoc(matched, nullptr, &max_val);
+            if (expected_max >= params.templ_thres[i] && std::fabs(expected_max - max_val) > 1e-3) {
+                Log.warn(__FUNCTION__, "| gray first match differs from matchTemplate", templ_name, max_val,
+                         expected_max);
+            }
+#endif
+            results.emplace_back(RawResult { .matched = matched, .templ = templ, .templ_name = templ_name });
+            continue;
+        }
+
+        if (params.batch && method == MatchMethod::Ccoeff && params.mask_ranges.empty()) {
+            batch_indices.emplace_back(results.size());
+            batch_templs.emplace_back(compiled->templ_match);
+            results.emplace_back(RawResult { .matched = cv::Mat(), .templ = templ, .templ_name = templ_name });
+            continue;
+        }
 
+        // 目前所有的匹配都是用 TM_CCOEFF_NORMED
+        int match_algorithm = cv::TM_CCOEFF_NORMED;
+
+        cv::Mat matched;
         if (params.mask_ranges.empty()) {
-            cv::matchTemplate(image_match, templ_match, matched, match_algorithm);
+            cv::matchTemplate(image_match, compiled->templ_match, matched, match_algorithm);
         }
-        else {
+        else if (params.mask_src) {
             // match 时使用的 mask_range 当作 RGB 的
-            auto mask_opt = calc_mask(
-                params.mask_ranges,
-                params.mask_src ? image_match : templ_match,
-                params.mask_src ? image_gray : templ_gray,
-                params.mask_close);
+            auto mask_opt = calc_mask(params.mask_ranges, image_match, image_gray, params.mask_close, templ_name);
             if (!mask_opt) {
-                return {};
+                results.emplace_back(RawResult { .matched = cv::Mat(), .templ = templ, .templ_name = templ_name });
+                continue;
             }
-            cv::matchTemplate(image_match, templ_match, matched, match_algorithm, mask_opt.value());
+            cv::matchTemplate(image_match, compiled->templ_match, matched, match_algorithm, mask_opt.value());
+        }
+        else {
+            cv::matchTemplate(image_match, compiled->templ_match, matched, match_algorithm, compiled->mask);
         }
 
-        if (method == MatchMethod::RGBCount || method == MatchMethod::HSVCount) {
-            auto templ_active_opt = calc_mask(params.color_scales, templ_count, templ_gray, params.color_close);
-            auto image_active_opt = calc_mask(params.color_scales, image_count, image_gray, params.color_close);
-            if (!image_active_opt || !templ_active_opt) [[unlikely]] {
-                return {};
+        if (is_count) {
+            const cv::Mat& image_count = method == MatchMethod::HSVCount ? image_hsv : image_match;
+            auto image_active_opt =
+                calc_mask(params.color_scales, image_count, image_gray, params.color_close, templ_name);
+            if (!image_active_opt) [[unlikely]] {
+                results.emplace_back(RawResult { .matched = cv::Mat(), .templ = templ, .templ_name = templ_name });
+                continue;
             }
-            cv::Mat templ_active = std::move(templ_active_opt).value();
             cv::Mat image_active = std::move(image_active_opt).value();
 
-            cv::threshold(templ_active, templ_active, 1, 1, cv::THRESH_BINARY);
             cv::threshold(image_active, image_active, 1, 1, cv::THRESH_BINARY);
             // 把 CCORR 当 count 用，计算 image_active 在 templ_active 形状内的像素数量
-            cv::Mat tp, fp;
-            int tp_fn = cv::countNonZero(templ_active);
-            cv::matchTemplate(image_active, templ_active, tp, cv::TM_CCORR);
-            tp.convertTo(tp, CV_32S);
-            cv::Mat templ_inactive = 1 - templ_active;
-            // TODO: 这里 TP+FP 是 image_active 的 count，可以消掉一个 matchtemplate
-            cv::matchTemplate(image_active, templ_inactive, fp, cv::TM_CCORR);
-            fp.convertTo(fp, CV_32S);
-            cv::Mat count_result;
-            cv::divide(2 * tp, tp + fp + tp_fn, count_result, 1, CV_32F); // 数色结果为 f1_score
-            cv::multiply(matched, count_result, matched);                 // 最终结果是数色和模板匹配的点积
+            cv::Mat tp;
+            cv::matchTemplate(image_active, compiled->templ_active, tp, cv::TM_CCORR);
+            // TP+FP 就是窗口内 image_active 的像素数量，用积分图算
+            cv::Mat active_sum;
+            cv::integral(image_active, active_sum, CV_32S);
+            apply_count_score(matched, tp, active_sum, compiled->templ_active.size(), compiled->tp_fn);
         }
         results.emplace_back(RawResult { .matched = matched, .templ = templ, .templ_name = templ_name });
     }
+
+    if (stop && stop()) {
+        return {};
+    }
+    if (!batch_templs.empty()) {
+        auto batch_matched = BatchTemplMatcher(image_match).match(batch_templs);
+        for (size_t i = 0; i < batch_indices.size(); ++i) {
+            auto& raw = results[batch_indices[i]];
+            raw.matched = std::move(batch_matched[i]);
+#ifdef ASST_DEBUG
+            // 和逐个 matchTemplate 的结果对比，确认批量匹配没有算错
+            cv::Mat expected, diff;
+            cv::matchTemplate(image_match, batch_templs[i], expected, cv::TM_CCOEFF_NORMED);
+            if (raw.matched.size() == expected.size()) {
+                cv::absdiff(raw.matched, expected, diff);
+                double max_diff = 0;
+                cv::minMaxLoc(diff, nullptr, &max_diff);
+                if (max_diff > 1e-3) {
+                    Log.warn(__FUNCTION__, "| batch match differs from matchTemplate", raw.templ_name, max_diff);
+                }
+            }
+            else {
+                Log.warn(__FUNCTION__, "| batch match size mismatch", raw.templ_name);
+            }
+#endif
+        }
+    }
     return results;
 }
+
+std::shared_ptr<const Matcher::CompiledTempl> Matcher::get_compiled_templ(
+    const cv::Mat& templ,
+    const std::string& templ_name,
+    MatchMethod method,
+    const MatcherConfig::Params& params)
+{
+    static std::mutex cache_mutex;
+    static std::unordered_map<std::string, std::shared_ptr<const CompiledTempl>> cache;
+
+    // 只包含影响模板预处理的参数，阈值等不影响
+    std::string key = templ_name;
+    key += "|" + std::to_string(static_cast<int>(method)) + "|";
+    if (!params.mask_src) {
+        key += MatcherConfig::ranges_key(params.mask_ranges);
+        key += params.mask_close ? "|close|" : "|open|";
+    }
+    else {
+        key += "src||";
+    }
+    if (method == MatchMethod::RGBCount || method == MatchMethod::HSVCount) {
+        key += MatcherConfig::ranges_key(params.color_scales);
+        key += params.color_close ? "|close" : "|open";
+    }
+    key += "|" + std::to_string(params.pyramid_level);
+
+    {
+        std::unique_lock<std::mutex> lock(cache_mutex);
+        auto iter = cache.find(key);
+        // 资源重新加载后模板会变成另一个 Mat
+        if (iter != cache.end() && iter->second->templ.data == templ.data) {
+            return iter->second;
+        }
+    }
+
+    auto compiled = compile_templ(templ, templ_name, method, params);
+    if (!compiled) {
+        return nullptr;
+    }
+
+    std::unique_lock<std::mutex> lock(cache_mutex);
+    if (cache.size() >= MaxCompiledTemplCacheSize) {
+        cache.clear();
+    }
+    cache.insert_or_assign(std::move(key), compiled);
+    return compiled;
+}
+
+std::shared_ptr<const Matcher::CompiledTempl> Matcher::compile_templ(
+    const cv::Mat& templ,
+    const std::string& templ_name,
+    MatchMethod method,
+    const MatcherConfig::Params& params)
+{
+    auto compiled = std::make_shared<CompiledTempl>();
+    compiled->templ = templ;
+    cv::cvtColor(templ, compiled->templ_match, cv::COLOR_BGR2RGB);
+    cv::cvtColor(templ, compiled->templ_gray, cv::COLOR_BGR2GRAY);
+    compiled->templ_mean = cv::mean(compiled->templ_match);
+
+    if (!params.mask_ranges.empty() && !params.mask_src) {
+        // match 时使用的 mask_range 当作 RGB 的
+        auto mask_opt =
+            calc_mask(params.mask_ranges, compiled->templ_match, compiled->templ_gray, params.mask_close, templ_name);
+        if (!mask_opt) {
+            return nullptr;
+        }
+        compiled->mask = std::move(mask_opt).value();
+    }
+
+    if (method == MatchMethod::RGBCount || method == MatchMethod::HSVCount) {
+        cv::Mat templ_count;
+        if (method == MatchMethod::HSVCount) {
+            cv::cvtColor(templ, templ_count, cv::COLOR_BGR2HSV);
+        }
+        else {
+            templ_count = compiled->templ_match;
+        }
+        auto templ_active_opt =
+            calc_mask(params.color_scales, templ_count, compiled->templ_gray, params.color_close, templ_name);
+        if (!templ_active_opt) [[unlikely]] {
+            return nullptr;
+        }
+        cv::Mat templ_active = std::move(templ_active_opt).value();
+        cv::threshold(templ_active, templ_active, 1, 1, cv::THRESH_BINARY);
+        compiled->tp_fn = cv::countNonZero(templ_active);
+        compiled->templ_active = std::move(templ_active);
+    }
+
+    // 由粗到细只用于不带掩码的 Ccoeff
+    if (params.pyramid_level > 0 && method == MatchMethod::Ccoeff && params.mask_ranges.empty()) {
+        const int factor = 1 << params.pyramid_level;
+        if (templ.cols / factor >= MinPyramidTemplSize && templ.rows / factor >= MinPyramidTemplSize) {
+            const double scale = 1.0 / factor;
+            cv::resize(compiled->templ_match, compiled->templ_small, cv::Size(), scale, scale, cv::INTER_AREA);
+        }
+    }
+    return compiled;
+}
+
+cv::Mat Matcher::match_coarse_to_fine(
+    const cv::Mat& image,
+    const cv::Mat& image_small,
+    const CompiledTempl& compiled,
+    int level,
+    double threshold)
+{
+    const int factor = 1 << level;
+    const cv::Mat& templ = compiled.templ_match;
+
+    cv::Mat coarse;
+    cv::matchTemplate(image_small, compiled.templ_small, coarse, cv::TM_CCOEFF_NORMED);
+    // 缩小后细节少了，得分一般会低一些，每缩小一层阈值放宽一点
+    const double coarse_threshold = threshold - PyramidThresholdDrop * level;
+
+    cv::Mat matched(image.rows - templ.rows + 1, image.cols - templ.cols + 1, CV_32F, cv::Scalar(0));
+    const cv::Size suppress((std::max)(1, compiled.templ_small.cols / 2), (std::max)(1, compiled.templ_small.rows / 2));
+    // 缩小一层，位置最多差一个 factor，在原图上把附近都算一遍
+    refine_candidates(coarse, coarse_threshold, MaxPyramidCandidates, suppress, factor, factor, image, templ, matched);
+    return matched;
+}
+
+cv::Mat Matcher::match_gray_first(
+    const cv::Mat& image,
+    const cv::Mat& image_gray,
+    const CompiledTempl& compiled,
+    double threshold)
+{
+    const cv::Mat& templ = compiled.templ_match;
+
+    cv::Mat coarse;
+    cv::matchTemplate(image_gray, compiled.templ_gray, coarse, cv::TM_CCOEFF_NORMED);
+
+    cv::Mat matched(image.rows - templ.rows + 1, image.cols - templ.cols + 1, CV_32F, cv::Scalar(0));
+    const cv::Size suppress((std::max)(1, templ.cols / 2), (std::max)(1, templ.rows / 2));
+    refine_candidates(coarse, threshold - GrayThresholdDrop, MaxGrayCandidates, suppress, 1, GrayRefineRadius, image,
+                      templ, matched);
+
+    // 没有候选能在彩色图上确认，可能是真正的位置灰度得分不高、没进候选，回退到完整的彩色匹配，
+    // 保证匹配不上的结果和不开 grayFirst 时一致
+    double max_val = 0.0;
+    cv::minMaxLoc(matched, nullptr, &max_val);
+    if (max_val < threshold) {
+        cv::matchTemplate(image, templ, matched, cv::TM_CCOEFF_NORMED);
+    }
+    return matched;
+}
+
+void Matcher::refine_candidates(
+    cv::Mat& coarse,
+    double coarse_threshold,
+    int max_candidates,
+    const cv::Size& suppress,
+    int factor,
+    int radius,
+    const cv::Mat& image,
+    const cv::Mat& templ,
+    cv::Mat& matched)
+{
+    const cv::Rect coarse_rect(0, 0, coarse.cols, coarse.rows);
+    const cv::Rect matched_rect(0, 0, matched.cols, matched.rows);
+    for (int n = 0; n < max_candidates; ++n) {
+        double max_val = 0.0;
+        cv::Point max_loc;
+        cv::minMaxLoc(coarse, nullptr, &max_val, nullptr, &max_loc);
+        if (!(max_val >= coarse_threshold)) {
+            break;
+        }
+        // 离这个候选太近的点不再作为候选
+        coarse(cv::Rect(max_loc.x - suppress.width, max_loc.y - suppress.height, 2 * suppress.width + 1,
+                        2 * suppress.height + 1) &
+               coarse_rect)
+            .setTo(-1);
+
+        const cv::Rect window =
+            cv::Rect(max_loc.x * factor - radius, max_loc.y * factor - radius, 2 * radius + 1, 2 * radius + 1) &
+            matched_rect;
+        if (window.empty()) {
+            continue;
+        }
+        cv::Mat refined;
+        cv::matchTemplate(
+            image(cv::Rect(window.x, window.y, window.width + templ.cols - 1, window.height + templ.rows - 1)),
+            templ,
+            refined,
+            cv::TM_CCOEFF_NORMED);
+        cv::Mat dst = matched(window);
+        cv::max(dst, refined, dst);
+    }
+}
+
+bool Matcher::prefilter_passed(const cv::Mat& image_sum, const cv::Scalar& templ_mean, const cv::Size& templ_size,
+                               int max_diff)
+{
+    // 直接比较窗口内的和，省掉每个窗口的除法。和都是整数，上下界取整后用 inRange 比较
+    const int cn = image_sum.channels();
+    const double area = templ_size.area();
+    cv::Scalar lower, upper;
+    for (int c = 0; c < cn; ++c) {
+        lower[c] = std::ceil((templ_mean[c] - max_diff) * area);
+        upper[c] = std::floor((templ_mean[c] + max_diff) * area);
+    }
+
+    // 每个窗口的和由积分图四个角加减得到，按行分块整块计算，各通道一起比较，找到一个窗口就返回
+    const int rows = image_sum.rows - templ_size.height;
+    const int cols = image_sum.cols - templ_size.width;
+    cv::Mat window_sum;
+    cv::Mat in_range;
+    for (int y = 0; y < rows; y += PrefilterBlockRows) {
+        const int block_rows = (std::min)(PrefilterBlockRows, rows - y);
+        auto corner = [&](int dx, int dy) {
+            return image_sum(cv::Rect(dx, y + dy, cols, block_rows));
+        };
+        cv::subtract(corner(templ_size.width, templ_size.height), corner(0, templ_size.height), window_sum);
+        cv::subtract(window_sum, corner(templ_size.width, 0), window_sum);
+        cv::add(window_sum, corner(0, 0), window_sum);
+        cv::inRange(window_sum, lower, upper, in_range);
+        if (cv::countNonZero(in_range) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Matcher::count_prefilter(const std::string& templ_name, bool rejected)
+{
+    struct PrefilterCount
+    {
+        size_t checked = 0;
+        size_t rejected = 0;
+    };
+    static std::mutex count_mutex;
+    static std::unordered_map<std::string, PrefilterCount> counts;
+
+    std::unique_lock<std::mutex> lock(count_mutex);
+    auto& count = counts[templ_name];
+    ++count.checked;
+    if (rejected) {
+        ++count.rejected;
+    }
+    if (count.checked % PrefilterLogInterval != 0) {
+        return;
+    }
+    const PrefilterCount total = count;
+    lock.unlock();
+
+    Log.info("Matcher prefilter |", templ_name, "rejected", total.rejected, "/", total.checked, ", rate",
+             static_cast<double>(total.rejected) / total.checked);
+}
+
+void Matcher::apply_count_score(cv::Mat& matched, const cv::Mat& tp, const cv::Mat& active_sum,
+                                const cv::Size& templ_size, int tp_fn)
+{
+    // 数色结果为 f1_score = 2TP / (TP+FP + TP+FN)，最终结果是数色和模板匹配的点积
+    // 逐像素一次算完，不生成中间的整图
+    for (int y = 0; y < matched.rows; ++y) {
+        float* matched_row = matched.ptr<float>(y);
+        const float* tp_row = tp.ptr<float>(y);
+        const int* sum_top = active_sum.ptr<int>(y);
+        const int* sum_bottom = active_sum.ptr<int>(y + templ_size.height);
+        for (int x = 0; x < matched.cols; ++x) {
+            const int tp_count = cvRound(tp_row[x]);
+            const int active_count =
+                sum_bottom[x + templ_size.width] - sum_bottom[x] - sum_top[x + templ_size.width] + sum_top[x];
+            const int denominator = active_count + tp_fn;
+            const float count_score = denominator == 0 ? 0.f : static_cast<float>(2 * tp_count) / denominator;
+            matched_row[x] *= count_score;
+        }
+    }
+}
+
+std::optional<cv::Mat> Matcher::calc_mask(
+    const MatchTaskInfo::Ranges& mask_ranges,
+    const cv::Mat& image,
+    const cv::Mat& image_gray,
+    bool with_close,
+    const std::string& templ_name)
+{
+    // Union all masks, not intersection
+    cv::Mat mask = cv::Mat::zeros(image_gray.size(), CV_8UC1);
+    for (const auto& range : mask_ranges) {
+        cv::Mat current_mask;
+        if (std::holds_alternative<MatchTaskInfo::GrayRange>(range)) {
+            const auto& gray_range = std::get<MatchTaskInfo::GrayRange>(range);
+            cv::inRange(image_gray, gray_range.first, gray_range.second, current_mask);
+        }
+        else if (std::holds_alternative<MatchTaskInfo::ColorRange>(range)) {
+            const auto& color_range = std::get<MatchTaskInfo::ColorRange>(range);
+            cv::inRange(image, color_range.first, color_range.second, current_mask);
+        }
+        else {
+            Log.error("The task with template", templ_name, "holds invalid mask range");
+            return std::nullopt;
+        }
+        cv::bitwise_or(mask, current_mask, mask);
+    }
+
+    if (with_close) {
+        cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(3, 3));
+        cv::morphologyEx(mask, mask, cv::MORPH_CLOSE, kernel);
+    }
+    return mask;
+}
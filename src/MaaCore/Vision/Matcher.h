@@ -26,12 +26,95 @@ namespace asst
             cv::Mat templ;
             std::string templ_name;
         };
-        static std::vector<RawResult> preproc_and_match(const cv::Mat& image, const MatcherConfig::Params& params);
+        // roi 为 context 中的区域，颜色转换的结果在同一个 context 的多次调用之间共享
+        // stop 在每个模板开始前检查，返回 true 时直接返回空
+        static std::vector<RawResult> preproc_and_match(
+            const ImageContext& context,
+            const Rect& roi,
+            const MatcherConfig::Params& params,
+            const std::function<bool()>& stop = nullptr);
 
     protected:
         virtual void _set_roi(const Rect& roi) override { set_roi(roi); }
 
     private:
+        static constexpr size_t MaxCompiledTemplCacheSize = 1024;
+        static constexpr double PyramidThresholdDrop = 0.1; // 缩小一层，粗匹配的阈值降低多少
+        static constexpr int MaxPyramidCandidates = 32;     // 粗匹配最多保留几个候选位置
+        static constexpr int MinPyramidTemplSize = 8;       // 缩小后模板太小就没法区分了，直接用原图匹配
+        static constexpr size_t PrefilterLogInterval = 100; // 每个模板预筛选多少次打印一次拒绝率
+        static constexpr int PrefilterBlockRows = 32;       // 预筛选时每次整块计算多少行窗口
+        static constexpr double GrayThresholdDrop = 0.1;    // 灰度匹配找候选位置时，阈值降低多少
+        static constexpr int MaxGrayCandidates = 32;        // 灰度匹配最多保留几个候选位置
+        static constexpr int GrayRefineRadius = 1;          // 彩色确认时，候选位置附近多大范围也一起算
+
+        // 模板这一侧的预处理结果，只和模板本身、匹配方法、掩码参数有关，不用每次匹配都重新算
+        struct CompiledTempl
+        {
+            cv::Mat templ; // BGR 原图
+            cv::Mat templ_match;    // RGB
+            cv::Mat templ_gray;     // 灰度
+            cv::Mat mask;           // 模板掩码，不使用掩码或使用原图掩码时为空
+            cv::Mat templ_active;   // 数色时，模板中要数的像素为 1，其余为 0
+            int tp_fn = 0;          // templ_active 中 1 的个数
+            cv::Mat templ_small;    // 由粗到细匹配时，缩小后的 RGB 模板。不使用或模板太小时为空
+            cv::Scalar templ_mean;  // RGB 各通道的平均值，预筛选用
+        };
+
+        // 按模板名和参数缓存；模板重新加载后自动失效
+        static std::shared_ptr<const CompiledTempl> get_compiled_templ(
+            const cv::Mat& templ,
+            const std::string& templ_name,
+            MatchMethod method,
+            const MatcherConfig::Params& params);
+        static std::shared_ptr<const CompiledTempl> compile_templ(
+            const cv::Mat& templ,
+            const std::string& templ_name,
+            MatchMethod method,
+            const MatcherConfig::Params& params);
+        // 先在缩小的图上找候选位置，再在原图上候选位置附近细化。其他位置的得分都为 0
+        static cv::Mat match_coarse_to_fine(
+            const cv::Mat& image,
+            const cv::Mat& image_small,
+            const CompiledTempl& compiled,
+            int level,
+            double threshold);
+        // 先在灰度图上找候选位置，再用彩色图算候选位置附近的得分。其他位置的得分都为 0
+        // 没有候选达到阈值时，回退到完整的彩色匹配
+        static cv::Mat match_gray_first(
+            const cv::Mat& image,
+            const cv::Mat& image_gray,
+            const CompiledTempl& compiled,
+            double threshold);
+        // 依次取 coarse 中得分最高的位置作为候选（坐标乘以 factor 对应到原图），
+        // 在 image 上把候选附近 radius 以内重新匹配一遍，得分写到 matched 里
+        static void refine_candidates(
+            cv::Mat& coarse,
+            double coarse_threshold,
+            int max_candidates,
+            const cv::Size& suppress,
+            int factor,
+            int radius,
+            const cv::Mat& image,
+            const cv::Mat& templ,
+            cv::Mat& matched);
+        // image_sum 为搜索图（RGB）的积分图，是否存在某个窗口的各通道平均值都和模板相差不超过 max_diff
+        static bool prefilter_passed(const cv::Mat& image_sum, const cv::Scalar& templ_mean, const cv::Size& templ_size,
+                                     int max_diff);
+        // 按模板统计预筛选的拒绝率，定期打印
+        static void count_prefilter(const std::string& templ_name, bool rejected);
+        // matched *= f1_score。tp 为 TM_CCORR 的结果，active_sum 为 image_active 的积分图
+        static void apply_count_score(cv::Mat& matched, const cv::Mat& tp, const cv::Mat& active_sum,
+                                      const cv::Size& templ_size, int tp_fn);
+        static std::optional<cv::Mat> calc_mask(
+            const MatchTaskInfo::Ranges& mask_ranges,
+            const cv::Mat& image,
+            const cv::Mat& image_gray,
+            bool with_close,
+            const std::string& templ_name);
+
+        ResultOpt _analyze() const;
+
         // FIXME: 老接口太难重构了，先弄个这玩意兼容下，后续慢慢全删掉
         mutable Result m_result;
     };
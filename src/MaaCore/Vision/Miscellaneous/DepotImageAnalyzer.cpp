@@ -255,6 +255,8 @@ int asst::DepotImageAnalyzer::match_quantity(const ItemInfo& item)
 
     RegionOCRer analyzer(m_image_resized);
     analyzer.set_task_info("NumberOcrReplace");
+    // 翻页时同一个格子的数字经常没变，二值化之后的图一样就不用再识别一遍
+    analyzer.set_use_cache(true);
     analyzer.set_roi(ocr_roi);
     analyzer.set_bin_threshold(task_ptr->special_params[0], task_ptr->special_params[1]);
 
@@ -1,11 +1,14 @@
 #include "PipelineAnalyzer.h"
 
+#include <atomic>
+#include <cstdint>
 #include <regex>
 #include <utility>
 
 #include "Config/TaskData.h"
 #include "Status.h"
 #include "Utils/Logger.hpp"
+#include "Utils/WorkerPool.hpp"
 #include "Vision/Matcher.h"
 #include "Vision/OCRer.h"
 #include "Vision/RegionOCRer.h"
@@ -13,92 +16,175 @@
 using namespace asst;
 
 PipelineAnalyzer::ResultOpt PipelineAnalyzer::analyze() const
+{
+    auto result_opt = m_parallel ? analyze_parallelly() : analyze_sequentially();
+    if (!result_opt) {
+        return std::nullopt;
+    }
+
+    // 缓存区域只在任务被选中时才更新，和逐个识别时的行为一致
+    const auto& task_ptr = result_opt->task_ptr;
+    switch (task_ptr->algorithm) {
+    case AlgorithmType::MatchTemplate:
+        Log.trace(__FUNCTION__, "| MatchTemplate", task_ptr->name);
+        break;
+    case AlgorithmType::OcrDetect:
+        Log.trace(__FUNCTION__, "| OcrDetect", task_ptr->name, std::get<OCRer::Result>(result_opt->result));
+        break;
+    default:
+        return result_opt;
+    }
+    if (m_inst && task_ptr->cache) {
+        status()->set_rect(task_ptr->name, result_opt->rect);
+    }
+    return result_opt;
+}
+
+PipelineAnalyzer::ResultOpt PipelineAnalyzer::analyze_sequentially() const
 {
     for (const std::string& task_name : m_tasks_name) {
-        const auto& task_ptr = Task.get(task_name);
-        // 可能有配置错误，导致不存在对应的任务
+        const auto task_ptr = get_task(task_name);
         if (task_ptr == nullptr) {
-            Log.error("Invalid task", task_name);
-#ifdef ASST_DEBUG
-            throw std::runtime_error("Invalid task: " + task_name);
-#endif
             continue;
         }
-
         // Log.trace(__FUNCTION__, task_ptr->name);
-        switch (task_ptr->algorithm) {
-        case AlgorithmType::JustReturn: {
-            return Result { .task_ptr = task_ptr };
-        } break;
-
-        case AlgorithmType::MatchTemplate:
-            if (auto match_opt = match(task_ptr)) {
-                Log.trace(__FUNCTION__, "| MatchTemplate", task_ptr->name);
-                return Result { .task_ptr = task_ptr, .result = *match_opt, .rect = match_opt->rect };
-            }
-            break;
-        case AlgorithmType::OcrDetect:
-            if (auto ocr_opt = ocr(task_ptr)) {
-                Log.trace(__FUNCTION__, "| OcrDetect", task_ptr->name, *ocr_opt);
-                return Result { .task_ptr = task_ptr, .result = ocr_opt->front(), .rect = ocr_opt->front().rect };
-            }
-            break;
-        default:
-            break;
+        if (auto result_opt = evaluate(task_ptr, get_cache(task_ptr))) {
+            return result_opt;
         }
     }
     return std::nullopt;
 }
 
-Matcher::ResultOpt PipelineAnalyzer::match(const std::shared_ptr<TaskInfo>& task_ptr) const
+PipelineAnalyzer::ResultOpt PipelineAnalyzer::analyze_parallelly() const
 {
-    Matcher match_analyzer(m_image, m_roi);
+    // 任务信息和缓存区域都在当前线程上取好，工作线程只做识别
+    std::vector<std::shared_ptr<TaskInfo>> tasks;
+    std::vector<std::optional<Rect>> caches;
+    for (const std::string& task_name : m_tasks_name) {
+        auto task_ptr = get_task(task_name);
+        if (task_ptr == nullptr) {
+            continue;
+        }
+        caches.emplace_back(get_cache(task_ptr));
+        tasks.emplace_back(std::move(task_ptr));
+        // JustReturn 一定成功，后面的任务没必要再识别了
+        if (tasks.back()->algorithm == AlgorithmType::JustReturn) {
+            break;
+        }
+    }
+    const size_t count = tasks.size();
+    if (count <= 1 || tasks.front()->algorithm == AlgorithmType::JustReturn) {
+        return count == 0 ? std::nullopt : evaluate(tasks.front(), caches.front());
+    }
 
-    const auto match_task_ptr = std::dynamic_pointer_cast<MatchTaskInfo>(task_ptr);
-    if (ranges::all_of(match_task_ptr->templ_thresholds, [](double t) { return t > 1.0; })) {
-        Log.info(match_task_ptr->name, "'s threshold is", match_task_ptr->templ_thresholds, ", just skip");
+    // 颜色转换的缓存是第一次用到时才创建的，先在当前线程上建好
+    image_context();
+
+    std::vector<ResultOpt> results(count);
+    std::atomic_size_t best = SIZE_MAX; // 目前识别成功的任务中最靠前的下标
+    // 下标按从小到大领取；已经有更靠前的任务成功时，后面的就不用做了
+    WorkerPool::get_instance().parallel_for(count, [&](size_t index) {
+        // 识别途中更靠前的任务成功了，剩下的模板也不用匹配了
+        auto stop = [&best, index]() { return index > best; };
+        if (stop()) {
+            return;
+        }
+        auto result_opt = evaluate(tasks[index], caches[index], stop);
+        if (!result_opt) {
+            return;
+        }
+        results[index] = std::move(result_opt);
+        size_t cur_best = best;
+        while (index < cur_best && !best.compare_exchange_weak(cur_best, index)) {
+        }
+    });
+
+    if (best >= count) {
         return std::nullopt;
     }
-    match_analyzer.set_task_info(match_task_ptr);
+    return std::move(results[best]);
+}
 
-    bool use_cache = m_inst && match_task_ptr->cache;
-    if (use_cache) {
-        auto cache_opt = status()->get_rect(match_task_ptr->name);
-        if (cache_opt) {
-            match_analyzer.set_roi(*cache_opt);
+std::shared_ptr<TaskInfo> PipelineAnalyzer::get_task(const std::string& task_name) const
+{
+    auto task_ptr = Task.get(task_name);
+    // 可能有配置错误，导致不存在对应的任务
+    if (task_ptr == nullptr) {
+        Log.error("Invalid task", task_name);
+#ifdef ASST_DEBUG
+        throw std::runtime_error("Invalid task: " + task_name);
+#endif
+    }
+    return task_ptr;
+}
+
+std::optional<Rect> PipelineAnalyzer::get_cache(const std::shared_ptr<TaskInfo>& task_ptr) const
+{
+    if (!m_inst || !task_ptr->cache) {
+        return std::nullopt;
+    }
+    return status()->get_rect(task_ptr->name);
+}
+
+PipelineAnalyzer::ResultOpt PipelineAnalyzer::evaluate(const std::shared_ptr<TaskInfo>& task_ptr,
+                                                       const std::optional<Rect>& cache_opt,
+                                                       const std::function<bool()>& stop) const
+{
+    switch (task_ptr->algorithm) {
+    case AlgorithmType::JustReturn:
+        return Result { .task_ptr = task_ptr };
+
+    case AlgorithmType::MatchTemplate:
+        if (auto match_opt = match(task_ptr, cache_opt, stop)) {
+            return Result { .task_ptr = task_ptr, .result = *match_opt, .rect = match_opt->rect };
         }
+        break;
+    case AlgorithmType::OcrDetect:
+        if (auto ocr_opt = ocr(task_ptr, cache_opt)) {
+            return Result { .task_ptr = task_ptr, .result = ocr_opt->front(), .rect = ocr_opt->front().rect };
+        }
+        break;
+    default:
+        break;
     }
+    return std::nullopt;
+}
 
-    const auto& result_opt = match_analyzer.analyze();
+Matcher::ResultOpt PipelineAnalyzer::match(const std::shared_ptr<TaskInfo>& task_ptr,
+                                           const std::optional<Rect>& cache_opt,
+                                           const std::function<bool()>& stop) const
+{
+    Matcher match_analyzer(m_image, m_roi);
+    match_analyzer.set_image_context(image_context());
+    match_analyzer.set_stop_predicate(stop);
 
-    if (!result_opt) {
+    const auto match_task_ptr = std::dynamic_pointer_cast<MatchTaskInfo>(task_ptr);
+    if (ranges::all_of(match_task_ptr->templ_thresholds, [](double t) { return t > 1.0; })) {
+        Log.info(match_task_ptr->name, "'s threshold is", match_task_ptr->templ_thresholds, ", just skip");
         return std::nullopt;
     }
-    if (use_cache) {
-        status()->set_rect(match_task_ptr->name, result_opt->rect);
+    match_analyzer.set_task_info(match_task_ptr);
+
+    if (cache_opt) {
+        match_analyzer.set_roi(*cache_opt);
     }
 
-    return result_opt;
+    return match_analyzer.analyze();
 }
 
-OCRer::ResultsVecOpt PipelineAnalyzer::ocr(const std::shared_ptr<TaskInfo>& task_ptr) const
+OCRer::ResultsVecOpt PipelineAnalyzer::ocr(const std::shared_ptr<TaskInfo>& task_ptr,
+                                           const std::optional<Rect>& cache_opt) const
 {
     const auto ocr_task_ptr = std::dynamic_pointer_cast<OcrTaskInfo>(task_ptr);
 
     bool det = !ocr_task_ptr->without_det;
-    bool use_cache = m_inst && ocr_task_ptr->cache;
-
-    std::optional<Rect> cache_opt;
-    if (use_cache) {
-        cache_opt = status()->get_rect(ocr_task_ptr->name);
-    }
 
     OCRer::ResultsVec result_vec;
 
     if (det) {
         OCRer analyzer(m_image, m_roi);
         analyzer.set_task_info(ocr_task_ptr);
-        if (use_cache && cache_opt) {
+        if (cache_opt) {
             analyzer.set_roi(*cache_opt);
             analyzer.set_without_det(true);
         }
@@ -110,8 +196,9 @@ OCRer::ResultsVecOpt PipelineAnalyzer::ocr(const std::shared_ptr<TaskInfo>& task
     }
     else {
         RegionOCRer analyzer(m_image, m_roi);
+        analyzer.set_image_context(image_context());
         analyzer.set_task_info(ocr_task_ptr);
-        if (use_cache && cache_opt) {
+        if (cache_opt) {
             analyzer.set_roi(*cache_opt);
         }
         auto result_opt = analyzer.analyze();
@@ -121,9 +208,5 @@ OCRer::ResultsVecOpt PipelineAnalyzer::ocr(const std::shared_ptr<TaskInfo>& task
         result_vec = { std::move(*result_opt) };
     }
 
-    if (use_cache && !result_vec.empty()) {
-        status()->set_rect(ocr_task_ptr->name, result_vec.front().rect);
-    }
-
     return result_vec;
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include "Vision/VisionHelper.h"
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -28,13 +29,30 @@ namespace asst
         virtual ~PipelineAnalyzer() override = default;
 
         void set_tasks(std::vector<std::string> tasks_name) { m_tasks_name = std::move(tasks_name); }
+        // 在 WorkerPool 上同时识别所有任务，结果和逐个识别一致（排在前面的任务优先）。默认关闭
+        // 排在前面的任务成功后，后面正在匹配的模板任务会在下一个模板前放弃；OCR 只能等它做完
+        void set_parallel(bool parallel) noexcept { m_parallel = parallel; }
 
         ResultOpt analyze() const;
 
     private:
-        Matcher::ResultOpt match(const std::shared_ptr<TaskInfo>& task_ptr) const;
-        OCRer::ResultsVecOpt ocr(const std::shared_ptr<TaskInfo>& task_ptr) const;
+        ResultOpt analyze_sequentially() const;
+        ResultOpt analyze_parallelly() const;
+
+        std::shared_ptr<TaskInfo> get_task(const std::string& task_name) const;
+        std::optional<Rect> get_cache(const std::shared_ptr<TaskInfo>& task_ptr) const;
+        // 只做识别，不读写 status，可以在工作线程上调用。stop 返回 true 时放弃识别
+        ResultOpt evaluate(
+            const std::shared_ptr<TaskInfo>& task_ptr,
+            const std::optional<Rect>& cache_opt,
+            const std::function<bool()>& stop = nullptr) const;
+        Matcher::ResultOpt match(
+            const std::shared_ptr<TaskInfo>& task_ptr,
+            const std::optional<Rect>& cache_opt,
+            const std::function<bool()>& stop) const;
+        OCRer::ResultsVecOpt ocr(const std::shared_ptr<TaskInfo>& task_ptr, const std::optional<Rect>& cache_opt) const;
 
         std::vector<std::string> m_tasks_name;
+        bool m_parallel = false;
     };
 }
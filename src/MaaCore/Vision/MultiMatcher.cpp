@@ -1,6 +1,8 @@
 #include "MultiMatcher.h"
 
 #include "Utils/Ranges.hpp"
+#include <cfloat>
+#include <unordered_map>
 #include <utility>
 
 #include "Utils/NoWarningCV.h"
@@ -14,7 +16,32 @@ using namespace asst;
 
 MultiMatcher::ResultsVecOpt MultiMatcher::analyze() const
 {
-    auto match_results = Matcher::preproc_and_match(make_roi(m_image, m_roi), m_params);
+    // 画面在 roi 内没有变化时，直接用上次的结果
+    const auto cache_key = m_frame ? params_key() : std::nullopt;
+    if (cache_key) {
+        if (auto cached = load_cached<ResultsVecOpt>("MultiMatcher|" + *cache_key, m_roi)) {
+            if (*cached) {
+                // FIXME: 老接口太难重构了，先弄个这玩意兼容下，后续慢慢全删掉
+                m_result = **cached;
+            }
+            return *cached;
+        }
+    }
+
+    auto result = _analyze();
+    if (cache_key) {
+        store_cached("MultiMatcher|" + *cache_key, m_roi, result);
+    }
+    return result;
+}
+
+MultiMatcher::ResultsVecOpt MultiMatcher::_analyze() const
+{
+    // 由粗到细和灰度优先都只细化有限个候选位置，其他位置的得分是 0，会漏掉结果，这里都不用
+    auto params = m_params;
+    params.pyramid_level = 0;
+    params.gray_first = false;
+    auto match_results = Matcher::preproc_and_match(*image_context(), m_roi, params);
 
     std::vector<Result> results;
     for (size_t index = 0; index < match_results.size(); ++index) {
@@ -25,39 +52,82 @@ MultiMatcher::ResultsVecOpt MultiMatcher::analyze() const
 
         double threshold = m_params.templ_thres[index];
         int min_distance = (std::min)(templ.cols, templ.rows) / 2;
-        for (int i = 0; i != matched.rows; ++i) {
-            for (int j = 0; j != matched.cols; ++j) {
-                auto value = matched.at<float>(i, j);
-                if (value < threshold || std::isnan(value) || std::isinf(value)) {
-                    continue;
-                }
 
-                Rect rect(j + m_roi.x, i + m_roi.y, templ.cols, templ.rows);
-                bool need_push = true;
-                // 如果有两个点离得太近，只取里面得分高的那个
-                // 一般相邻的都是刚刚push进去的，这里倒序快一点
-                for (auto& iter : ranges::reverse_view(results)) {
-                    if (std::abs(j + m_roi.x - iter.rect.x) >= min_distance ||
-                        std::abs(i + m_roi.y - iter.rect.y) >= min_distance) {
-                        continue;
-                    }
+        // 先整图比较一遍阈值（OpenCV 内部是 SIMD 实现），只遍历超过阈值的点
+        // inRange 的上限是 FLT_MAX，NaN 和 Inf 都会被排除
+        cv::Mat above;
+        cv::inRange(matched, threshold, FLT_MAX, above);
+        std::vector<cv::Point> candidates;
+        cv::findNonZero(above, candidates);
+        if (candidates.empty()) {
+            continue;
+        }
 
-                    if (iter.score < value) {
-                        iter.rect = rect;
-                        iter.score = value;
-                        iter.templ_name = templ_name;
-                    } // else 这个点就放弃了
-                    need_push = false;
-                    break;
-                }
-                if (need_push) {
-                    Result tmp;
-                    tmp.rect = rect;
-                    tmp.score = value;
-                    tmp.templ_name = templ_name;
-                    results.emplace_back(std::move(tmp));
+        // 已有的结果按 min_distance 大小的网格分桶，每个点只和周围 3x3 个格子里的结果比较
+        const int cell_size = (std::max)(min_distance, 1);
+        std::unordered_map<uint64_t, std::vector<size_t>> grid;
+        auto cell_key = [&](int x, int y) {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(x / cell_size)) << 32) |
+                   static_cast<uint32_t>(y / cell_size);
+        };
+        for (size_t i = 0; i < results.size(); ++i) {
+            grid[cell_key(results[i].rect.x, results[i].rect.y)].emplace_back(i);
+        }
+
+        // findNonZero 按行优先的顺序输出，和逐像素遍历的顺序一致
+        for (const cv::Point& point : candidates) {
+            const float value = matched.at<float>(point);
+            const int x = point.x + m_roi.x;
+            const int y = point.y + m_roi.y;
+            Rect rect(x, y, templ.cols, templ.rows);
+
+            // 如果有两个点离得太近，只取里面得分高的那个
+            // 和之前倒序遍历的结果保持一致：有多个离得近的，取最后加入的那个
+            std::optional<size_t> near_index;
+            if (min_distance > 0) {
+                const int cx = x / cell_size;
+                const int cy = y / cell_size;
+                for (int ny = (std::max)(cy - 1, 0); ny <= cy + 1; ++ny) {
+                    for (int nx = (std::max)(cx - 1, 0); nx <= cx + 1; ++nx) {
+                        auto cell = grid.find(cell_key(nx * cell_size, ny * cell_size));
+                        if (cell == grid.end()) {
+                            continue;
+                        }
+                        for (size_t i : cell->second) {
+                            const auto& res = results[i];
+                            if (std::abs(x - res.rect.x) >= min_distance ||
+                                std::abs(y - res.rect.y) >= min_distance) {
+                                continue;
+                            }
+                            if (!near_index || *near_index < i) {
+                                near_index = i;
+                            }
+                        }
+                    }
                 }
             }
+
+            if (!near_index) {
+                grid[cell_key(x, y)].emplace_back(results.size());
+                Result tmp;
+                tmp.rect = rect;
+                tmp.score = value;
+                tmp.templ_name = templ_name;
+                results.emplace_back(std::move(tmp));
+                continue;
+            }
+
+            auto& near = results[*near_index];
+            if (near.score < value) {
+                // 位置变了，换到新的格子里
+                auto& old_cell = grid[cell_key(near.rect.x, near.rect.y)];
+                old_cell.erase(ranges::find(old_cell, *near_index));
+                grid[cell_key(x, y)].emplace_back(*near_index);
+
+                near.rect = rect;
+                near.score = value;
+                near.templ_name = templ_name;
+            } // else 这个点就放弃了
         }
     }
 
@@ -23,6 +23,8 @@ namespace asst
         virtual void _set_roi(const Rect& roi) override { set_roi(roi); }
 
     private:
+        ResultsVecOpt _analyze() const;
+
         // FIXME: 老接口太难重构了，先弄个这玩意兼容下，后续慢慢全删掉
         mutable ResultsVec m_result;
     };
@@ -12,24 +12,71 @@ using namespace asst;
 
 OCRer::ResultsVecOpt OCRer::analyze() const
 {
-    OcrPack* ocr_ptr = nullptr;
-    if (m_params.use_char_model) {
-        ocr_ptr = &CharOcr::get_instance();
+    ResultsVec raw_results = ocr_pack_().recognize(make_roi(m_image, m_roi), m_params.without_det, m_params.use_cache);
+
+    auto results_opt = postproc_(std::move(raw_results), m_roi);
+    if (!results_opt) {
+        return std::nullopt;
+    }
+    m_result = std::move(*results_opt);
+    return m_result;
+}
+
+std::vector<OCRer::ResultsVecOpt> OCRer::analyze_rois(const std::vector<Rect>& rois) const
+{
+    std::vector<cv::Mat> crops;
+    std::vector<Rect> rects;
+    crops.reserve(rois.size());
+    rects.reserve(rois.size());
+    for (const Rect& roi : rois) {
+        rects.emplace_back(correct_rect(roi, m_image));
+        crops.emplace_back(make_roi(m_image, rects.back()));
+    }
+    return analyze_crops(crops, rects);
+}
+
+std::vector<OCRer::ResultsVecOpt> OCRer::analyze_crops(const std::vector<cv::Mat>& crops,
+                                                       const std::vector<Rect>& rects) const
+{
+    std::vector<ResultsVec> raw_results(crops.size());
+    OcrPack& ocr_pack = ocr_pack_();
+    if (m_params.without_det && crops.size() > 1) {
+        ResultsVec batch_results = ocr_pack.recognize_batch(crops, m_params.use_cache);
+        for (size_t i = 0; i < batch_results.size() && i < crops.size(); ++i) {
+            raw_results[i].emplace_back(std::move(batch_results[i]));
+        }
     }
     else {
-        ocr_ptr = &WordOcr::get_instance();
+        for (size_t i = 0; i < crops.size(); ++i) {
+            raw_results[i] = ocr_pack.recognize(crops[i], m_params.without_det, m_params.use_cache);
+        }
+    }
+
+    std::vector<ResultsVecOpt> results;
+    results.reserve(crops.size());
+    for (size_t i = 0; i < crops.size(); ++i) {
+        results.emplace_back(postproc_(std::move(raw_results[i]), i < rects.size() ? rects[i] : Rect()));
+    }
+    return results;
+}
+
+OcrPack& OCRer::ocr_pack_() const
+{
+    if (m_params.use_char_model) {
+        return CharOcr::get_instance();
     }
-    ResultsVec raw_results = ocr_ptr->recognize(make_roi(m_image, m_roi), m_params.without_det);
-    ocr_ptr = nullptr;
+    return WordOcr::get_instance();
+}
 
-    /* post process */
+OCRer::ResultsVecOpt OCRer::postproc_(ResultsVec raw_results, const Rect& roi) const
+{
     ResultsVec results_vec;
     for (Result& res : raw_results) {
         if (res.text.empty() || std::isnan(res.score) || std::isinf(res.score)) {
             continue;
         }
 
-        postproc_rect_(res);
+        postproc_rect_(res, roi);
         postproc_trim_(res);
         postproc_replace_(res);
 
@@ -45,19 +92,17 @@ OCRer::ResultsVecOpt OCRer::analyze() const
     }
 
     Log.trace("Proceed", results_vec);
-
-    m_result = std::move(results_vec);
-    return m_result;
+    return results_vec;
 }
 
-void OCRer::postproc_rect_(Result& res) const
+void OCRer::postproc_rect_(Result& res, const Rect& roi) const
 {
     if (m_params.without_det) {
-        res.rect = m_roi;
+        res.rect = roi;
     }
     else {
-        res.rect.x += m_roi.x;
-        res.rect.y += m_roi.y;
+        res.rect.x += roi.x;
+        res.rect.y += roi.y;
     }
 }
 
@@ -74,12 +119,12 @@ void OCRer::postproc_replace_(Result& res) const
 
     for (const auto& [regex, new_str] : m_params.replace) {
         if (m_params.replace_full) {
-            if (std::regex_search(res.text, std::regex(regex))) {
+            if (std::regex_search(res.text, *regex)) {
                 res.text = new_str;
             }
         }
         else {
-            res.text = std::regex_replace(res.text, std::regex(regex), new_str);
+            res.text = std::regex_replace(res.text, *regex, new_str);
         }
     }
 }
@@ -19,6 +19,11 @@ namespace asst
         virtual ~OCRer() override = default;
 
         ResultsVecOpt analyze() const;
+        // 多个区域一起识别，结果和 rois 一一对应。不检测文字位置（without_det）时所有区域只推理一次
+        std::vector<ResultsVecOpt> analyze_rois(const std::vector<Rect>& rois) const;
+        // 同 analyze_rois，但传入的是已经裁好的图，rects 为这些图在原图上的位置
+        std::vector<ResultsVecOpt>
+            analyze_crops(const std::vector<cv::Mat>& crops, const std::vector<Rect>& rects) const;
         // FIXME: 老接口太难重构了，先弄个这玩意兼容下，后续慢慢全删掉
         const auto& get_result() const noexcept { return m_result; }
 
@@ -31,7 +36,9 @@ namespace asst
         using OCRerConfig::set_bin_trim_threshold;
 
     protected:
-        void postproc_rect_(Result& res) const;
+        OcrPack& ocr_pack_() const;
+        ResultsVecOpt postproc_(ResultsVec raw_results, const Rect& roi) const;
+        void postproc_rect_(Result& res, const Rect& roi) const;
         void postproc_trim_(Result& res) const;
         void postproc_replace_(Result& res) const;
 
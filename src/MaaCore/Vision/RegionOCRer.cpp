@@ -1,14 +1,59 @@
 #include "RegionOCRer.h"
 
+#include <array>
+#include <utility>
+
 #include "Utils/NoWarningCV.h"
 
 using namespace asst;
 
 RegionOCRer::ResultOpt RegionOCRer::analyze() const
 {
-    cv::Mat img_roi = make_roi(m_image, m_roi);
-    cv::Mat img_roi_gray;
-    cv::cvtColor(img_roi, img_roi_gray, cv::COLOR_BGR2GRAY);
+    auto results = analyze_rois({ m_roi });
+    if (results.empty() || !results.front()) {
+        return std::nullopt;
+    }
+    m_result = std::move(*results.front());
+    return m_result;
+}
+
+std::vector<RegionOCRer::ResultOpt> RegionOCRer::analyze_rois(const std::vector<Rect>& rois) const
+{
+    std::vector<ResultOpt> results(rois.size());
+
+    std::vector<size_t> indices;
+    std::vector<cv::Mat> crops;
+    std::vector<Rect> rects;
+    for (size_t i = 0; i < rois.size(); ++i) {
+        auto crop_opt = crop_text_(correct_rect(rois[i], m_image));
+        if (!crop_opt) {
+            continue;
+        }
+        indices.emplace_back(i);
+        crops.emplace_back(std::move(crop_opt->first));
+        rects.emplace_back(crop_opt->second);
+    }
+    if (crops.empty()) {
+        return results;
+    }
+
+    OCRer ocr_analyzer;
+    auto config = m_params;
+    config.without_det = true;
+    ocr_analyzer.set_params(std::move(config));
+
+    auto ocr_results = ocr_analyzer.analyze_crops(crops, rects);
+    for (size_t k = 0; k < ocr_results.size() && k < indices.size(); ++k) {
+        if (ocr_results[k]) {
+            results[indices[k]] = std::move(ocr_results[k]->front());
+        }
+    }
+    return results;
+}
+
+std::optional<std::pair<cv::Mat, Rect>> RegionOCRer::crop_text_(const Rect& roi) const
+{
+    cv::Mat img_roi_gray = image_context()->gray(roi);
     cv::Mat bin;
     cv::inRange(img_roi_gray, m_params.bin_threshold_lower, m_params.bin_threshold_upper, bin);
 
@@ -20,48 +65,39 @@ RegionOCRer::ResultOpt RegionOCRer::analyze() const
     if (bounding_rect.empty()) {
         return std::nullopt;
     }
-    auto expand_roi = [](Rect& roi, int exp) {
+    auto expand_roi = [](Rect& rect, int exp) {
         if (exp == 0) return;
-        roi.x -= exp;
-        roi.y -= exp;
-        roi.width += 2 * exp;
-        roi.height += 2 * exp;
+        rect.x -= exp;
+        rect.y -= exp;
+        rect.width += 2 * exp;
+        rect.height += 2 * exp;
     };
     expand_roi(bounding_rect, m_params.bin_expansion);
 
-    auto new_roi = bounding_rect;
-    new_roi.x += m_roi.x;
-    new_roi.y += m_roi.y;
-
+    if (m_use_raw) {
+        // 扩展后可能超出图像边界，裁剪前先修正
+        auto new_roi = bounding_rect;
+        new_roi.x += roi.x;
+        new_roi.y += roi.y;
+        new_roi = correct_rect(new_roi, m_image);
 #ifdef ASST_DEBUG
-    cv::rectangle(m_image_draw, make_rect<cv::Rect>(new_roi), cv::Scalar(0, 0, 255), 1);
+        cv::rectangle(m_image_draw, make_rect<cv::Rect>(new_roi), cv::Scalar(0, 0, 255), 1);
 #endif // ASST_DEBUG
-
-    OCRer ocr_analyzer;
-    if (m_use_raw) {
-        ocr_analyzer = OCRer(m_image, new_roi);
-    }
-    else {
-        cv::Mat bin3;
-        std::array arr_bin3 { bin, bin, bin };
-        cv::merge(arr_bin3, bin3);
-        ocr_analyzer = OCRer(bin3, bounding_rect);
+        return std::make_pair(make_roi(m_image, new_roi), new_roi);
     }
 
-    auto config = m_params;
-    config.without_det = true;
-    ocr_analyzer.set_params(std::move(config));
-
-    auto result = ocr_analyzer.analyze();
-    if (!result) {
-        return std::nullopt;
-    }
-    m_result = result->front();
-    if (!m_use_raw) {
-        m_result.rect.x += m_roi.x;
-        m_result.rect.y += m_roi.y;
-    }
-    return m_result;
+    cv::Mat bin3;
+    std::array arr_bin3 { bin, bin, bin };
+    cv::merge(arr_bin3, bin3);
+    // 扩展后可能超出 roi 的边界，裁剪前先修正
+    bounding_rect = correct_rect(bounding_rect, bin3);
+    auto new_roi = bounding_rect;
+    new_roi.x += roi.x;
+    new_roi.y += roi.y;
+#ifdef ASST_DEBUG
+    cv::rectangle(m_image_draw, make_rect<cv::Rect>(new_roi), cv::Scalar(0, 0, 255), 1);
+#endif // ASST_DEBUG
+    return std::make_pair(make_roi(bin3, bounding_rect), new_roi);
 }
 
 void asst::RegionOCRer::bin_left_trim(cv::Mat& bin) const
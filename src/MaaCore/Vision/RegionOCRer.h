@@ -14,6 +14,8 @@ namespace asst
         virtual ~RegionOCRer() override = default;
 
         ResultOpt analyze() const;
+        // 多个区域一起识别，所有区域只推理一次。结果和 rois 一一对应
+        std::vector<ResultOpt> analyze_rois(const std::vector<Rect>& rois) const;
         void set_use_raw(bool use_raw) { m_use_raw = use_raw; }
         // FIXME: 老接口太难重构了，先弄个这玩意兼容下，后续慢慢全删掉
         const auto& get_result() const noexcept { return m_result; }
@@ -22,6 +24,8 @@ namespace asst
         using OCRerConfig::set_without_det;
         virtual void _set_roi(const Rect& roi) override { set_roi(roi); }
 
+        // 二值化后找到文字所在的区域，返回送去识别的图和它在原图上的位置。区域内没有文字时返回 nullopt
+        std::optional<std::pair<cv::Mat, Rect>> crop_text_(const Rect& roi) const;
         void bin_left_trim(cv::Mat& bin) const;
         void bin_right_trim(cv::Mat& bin) const;
 
@@ -9,6 +9,7 @@ using namespace asst;
 TemplDetOCRer::ResultsVecOpt TemplDetOCRer::analyze() const
 {
     MultiMatcher flag_analyzer(m_image, m_roi);
+    flag_analyzer.set_image_context(image_context());
     flag_analyzer.set_params(MatcherConfig::m_params);
 
     auto matched_vec_opt = flag_analyzer.analyze();
@@ -17,14 +18,23 @@ TemplDetOCRer::ResultsVecOpt TemplDetOCRer::analyze() const
     }
     auto& matched_vec = *matched_vec_opt;
 
-    ResultsVec results;
+    std::vector<Rect> rois;
+    rois.reserve(matched_vec.size());
     for (const auto& matched : matched_vec) {
-        Rect roi = matched.rect.move(m_flag_rect_move);
+        rois.emplace_back(matched.rect.move(m_flag_rect_move));
+    }
 
-        RegionOCRer ocr_analyzer(m_image, roi);
-        ocr_analyzer.set_params(OCRerConfig::m_params);
-        ocr_analyzer.set_use_raw(m_use_raw);
-        auto ocr_opt = ocr_analyzer.analyze();
+    // 所有标志旁边的文字一起识别
+    RegionOCRer ocr_analyzer(m_image);
+    ocr_analyzer.set_image_context(image_context());
+    ocr_analyzer.set_params(OCRerConfig::m_params);
+    ocr_analyzer.set_use_raw(m_use_raw);
+    auto ocr_results = ocr_analyzer.analyze_rois(rois);
+
+    ResultsVec results;
+    for (size_t i = 0; i < matched_vec.size() && i < ocr_results.size(); ++i) {
+        const auto& matched = matched_vec[i];
+        const auto& ocr_opt = ocr_results[i];
         if (!ocr_opt) {
             continue;
         }
@@ -0,0 +1,170 @@
+#include "TileChangeTracker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+
+#include "Utils/Ranges.hpp"
+
+using namespace asst;
+
+bool TileChangeTracker::update(const cv::Mat& prev, const cv::Mat& cur)
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+    ++m_seq;
+    if (m_frame_size != cur.size()) {
+        m_frame_size = cur.size();
+        m_tile_cols = (cur.cols + TileSize - 1) / TileSize;
+        m_tile_rows = (cur.rows + TileSize - 1) / TileSize;
+        m_tile_seq.assign(static_cast<size_t>(m_tile_cols) * m_tile_rows, m_seq);
+        m_row_changed.assign(m_tile_cols, 0);
+        m_cache.clear();
+        m_force_full = true;
+    }
+
+    if (m_force_full || cur.empty() || prev.size() != cur.size() || prev.type() != cur.type() ||
+        prev.data == cur.data) {
+        m_force_full = false;
+        ranges::fill(m_tile_seq, m_seq);
+        m_content_seq = m_seq;
+        return true;
+    }
+
+    // 先整行比较，绝大部分行都是完全相同的；有差异的行再按 tile 切开比较。
+    // memcmp 在各平台的标准库里都是 SIMD 实现，比手写逐像素比较快得多
+    const size_t elem_size = cur.elemSize();
+    const size_t row_bytes = cur.cols * elem_size;
+    bool any_changed = false;
+    for (int ty = 0; ty < m_tile_rows; ++ty) {
+        ranges::fill(m_row_changed, uint8_t(0));
+        int pending = m_tile_cols;
+        const int y_end = (std::min)(cur.rows, (ty + 1) * TileSize);
+        for (int y = ty * TileSize; y < y_end && pending > 0; ++y) {
+            const uchar* prev_row = prev.ptr(y);
+            const uchar* cur_row = cur.ptr(y);
+            if (std::memcmp(prev_row, cur_row, row_bytes) == 0) {
+                continue;
+            }
+            for (int tx = 0; tx < m_tile_cols; ++tx) {
+                if (m_row_changed[tx]) {
+                    continue;
+                }
+                const size_t offset = static_cast<size_t>(tx) * TileSize * elem_size;
+                const size_t len = (std::min)(static_cast<size_t>(TileSize) * elem_size, row_bytes - offset);
+                if (std::memcmp(prev_row + offset, cur_row + offset, len) != 0) {
+                    m_row_changed[tx] = 1;
+                    --pending;
+                }
+            }
+        }
+        if (pending == m_tile_cols) {
+            continue;
+        }
+        any_changed = true;
+        uint64_t* tile_seq = m_tile_seq.data() + static_cast<size_t>(ty) * m_tile_cols;
+        for (int tx = 0; tx < m_tile_cols; ++tx) {
+            if (m_row_changed[tx]) {
+                tile_seq[tx] = m_seq;
+            }
+        }
+    }
+
+    if (any_changed) {
+        m_content_seq = m_seq;
+    }
+    return any_changed;
+}
+
+void TileChangeTracker::reset()
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+    ++m_seq;
+    ranges::fill(m_tile_seq, m_seq);
+    m_content_seq = m_seq;
+    m_force_full = true;
+    m_cache.clear();
+}
+
+uint64_t TileChangeTracker::frame_seq() const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_seq;
+}
+
+uint64_t TileChangeTracker::content_seq() const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_content_seq;
+}
+
+bool TileChangeTracker::changed_since(const Rect& roi, const cv::Size& image_size, uint64_t seq) const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return _changed_since(roi, image_size, seq);
+}
+
+std::optional<std::any> TileChangeTracker::load(const std::string& key, const Rect& roi, const cv::Size& image_size,
+                                                uint64_t seq) const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+    auto iter = m_cache.find(key + roi.to_string());
+    if (iter == m_cache.end() || iter->second.image_size != image_size) {
+        return std::nullopt;
+    }
+    // 两帧中较早的那一帧之后都没有变化，说明两帧在 roi 内完全相同
+    if (_changed_since(roi, image_size, (std::min)(iter->second.seq, seq))) {
+        return std::nullopt;
+    }
+    return iter->second.result;
+}
+
+void TileChangeTracker::store(const std::string& key, const Rect& roi, const cv::Size& image_size, uint64_t seq,
+                              std::any result)
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+    if (seq == 0 || seq > m_seq) {
+        return;
+    }
+    if (m_cache.size() >= MaxCacheSize) {
+        m_cache.clear();
+    }
+    m_cache.insert_or_assign(key + roi.to_string(),
+                             CacheEntry { .image_size = image_size, .seq = seq, .result = std::move(result) });
+}
+
+bool TileChangeTracker::_changed_since(const Rect& roi, const cv::Size& image_size, uint64_t seq) const
+{
+    if (seq == 0 || seq > m_seq || m_tile_seq.empty() || image_size.width <= 0 || image_size.height <= 0) {
+        return true;
+    }
+
+    const Rect area = roi.empty() ? Rect(0, 0, image_size.width, image_size.height) : roi;
+    const double scale_x = static_cast<double>(m_frame_size.width) / image_size.width;
+    const double scale_y = static_cast<double>(m_frame_size.height) / image_size.height;
+
+    // 缩放时会用到邻近的像素，四周各多算一个像素
+    const int left = (std::max)(0, static_cast<int>(std::floor(area.x * scale_x)) - 1);
+    const int top = (std::max)(0, static_cast<int>(std::floor(area.y * scale_y)) - 1);
+    const int right =
+        (std::min)(m_frame_size.width, static_cast<int>(std::ceil((area.x + area.width) * scale_x)) + 1);
+    const int bottom =
+        (std::min)(m_frame_size.height, static_cast<int>(std::ceil((area.y + area.height) * scale_y)) + 1);
+    if (left >= right || top >= bottom) {
+        return true;
+    }
+
+    for (int ty = top / TileSize; ty <= (bottom - 1) / TileSize; ++ty) {
+        const uint64_t* tile_seq = m_tile_seq.data() + static_cast<size_t>(ty) * m_tile_cols;
+        for (int tx = left / TileSize; tx <= (right - 1) / TileSize; ++tx) {
+            if (tile_seq[tx] > seq) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <any>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/AsstTypes.h"
+#include "Utils/NoWarningCVMat.h"
+
+namespace asst
+{
+    // 逐 tile 比较相邻两帧截图，记录每个 tile 最后一次发生变化的帧序号，
+    // 据此判断某个 roi 在某一帧之后有没有像素变化，没变化的直接复用之前的识别结果
+    class TileChangeTracker
+    {
+    public:
+        static constexpr int TileSize = 32;
+        static constexpr size_t MaxCacheSize = 512;
+
+        // 一张图像对应的帧，交给 VisionHelper::set_frame_ref 后，分析器可以复用没有变化区域的结果
+        struct FrameRef
+        {
+            std::shared_ptr<TileChangeTracker> tracker = nullptr;
+            uint64_t seq = 0; // 0 表示不对应任何帧
+
+            explicit operator bool() const noexcept { return tracker != nullptr && seq != 0; }
+        };
+
+    public:
+        TileChangeTracker() = default;
+        TileChangeTracker(const TileChangeTracker&) = delete;
+        TileChangeTracker(TileChangeTracker&&) = delete;
+        ~TileChangeTracker() = default;
+
+        // 新截到一帧 cur（原始分辨率），和上一帧 prev 逐 tile 比较，返回是否有任何像素变化
+        bool update(const cv::Mat& prev, const cv::Mat& cur);
+        // 当前帧的内容不可信（例如被替换成了占位图），开始新的一帧并视为全部变化，同时清空结果缓存
+        void reset();
+
+        uint64_t frame_seq() const;
+        uint64_t content_seq() const; // 画面内容最近一次变化时的帧序号，画面不变则保持不变
+
+        // roi 为 image_size 坐标系（一般是缩放后的图）下的区域，返回 roi 在 seq 这一帧之后是否有变化
+        // 无法判断时一律视为有变化
+        bool changed_since(const Rect& roi, const cv::Size& image_size, uint64_t seq) const;
+
+        // key 需要包含所有影响识别结果的参数；roi 需要包含所有会被读取的像素
+        std::optional<std::any> load(const std::string& key, const Rect& roi, const cv::Size& image_size,
+                                     uint64_t seq) const;
+        void store(const std::string& key, const Rect& roi, const cv::Size& image_size, uint64_t seq,
+                   std::any result);
+
+        TileChangeTracker& operator=(const TileChangeTracker&) = delete;
+        TileChangeTracker& operator=(TileChangeTracker&&) = delete;
+
+    private:
+        struct CacheEntry
+        {
+            cv::Size image_size;
+            uint64_t seq = 0;
+            std::any result;
+        };
+
+        bool _changed_since(const Rect& roi, const cv::Size& image_size, uint64_t seq) const;
+
+        mutable std::shared_mutex m_mutex;
+        uint64_t m_seq = 0;
+        uint64_t m_content_seq = 0;
+        bool m_force_full = true;
+        cv::Size m_frame_size;
+        int m_tile_cols = 0;
+        int m_tile_rows = 0;
+        std::vector<uint64_t> m_tile_seq;    // 每个 tile 最后一次变化的帧序号
+        std::vector<uint8_t> m_row_changed; // update 时一行 tile 的比较结果，复用内存
+        std::unordered_map<std::string, CacheEntry> m_cache;
+    };
+} // namespace asst
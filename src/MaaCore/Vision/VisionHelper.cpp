@@ -23,6 +23,8 @@ VisionHelper::VisionHelper(const cv::Mat& image, const Rect& roi, Assistant* ins
 void VisionHelper::set_image(const cv::Mat& image)
 {
     m_image = image;
+    m_frame = {};
+    m_image_context = nullptr;
 #ifdef ASST_DEBUG
     m_image_draw = image.clone();
 #endif
@@ -40,6 +42,24 @@ void VisionHelper::set_log_tracing(bool enable)
     m_log_tracing = enable;
 }
 
+void VisionHelper::set_frame_ref(TileChangeTracker::FrameRef frame)
+{
+    m_frame = std::move(frame);
+}
+
+void VisionHelper::set_image_context(std::shared_ptr<ImageContext> context)
+{
+    m_image_context = std::move(context);
+}
+
+const std::shared_ptr<ImageContext>& VisionHelper::image_context() const
+{
+    if (!m_image_context || !m_image_context->is_of(m_image)) {
+        m_image_context = std::make_shared<ImageContext>(m_image);
+    }
+    return m_image_context;
+}
+
 Rect VisionHelper::correct_rect(const Rect& rect, const cv::Mat& image)
 {
     if (image.empty()) {
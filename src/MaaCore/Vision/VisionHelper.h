@@ -1,10 +1,14 @@
 #pragma once
 
+#include <functional>
+
 #include "Common/AsstTypes.h"
 #include "InstHelper.h"
 #include "Utils/NoWarningCVMat.h"
 #include "Utils/Platform.hpp"
 #include "Utils/Ranges.hpp"
+#include "Vision/ImageContext.h"
+#include "Vision/TileChangeTracker.h"
 
 // #ifndef  ASST_DEBUG
 // #define ASST_DEBUG
@@ -29,6 +33,12 @@ namespace asst
         virtual void set_image(const cv::Mat& image);
         virtual void set_roi(const Rect& roi);
         virtual void set_log_tracing(bool enable);
+        // 声明 m_image 就是 frame 这一帧，之后没有变化的 roi 可以直接复用之前的识别结果。set_image 后失效
+        void set_frame_ref(TileChangeTracker::FrameRef frame);
+        // 和同一帧上的其他分析器共享颜色转换结果。不是 m_image 这张图的会被忽略
+        void set_image_context(std::shared_ptr<ImageContext> context);
+        // 识别途中会不时检查，返回 true 时放弃还没做的部分，这次的结果作废。并行识别时用来提前结束
+        void set_stop_predicate(std::function<bool()> pred) { m_stop_predicate = std::move(pred); }
 
         bool save_img(const std::filesystem::path& relative_dir = utils::path("debug"));
 
@@ -42,16 +52,50 @@ namespace asst
     protected:
         static Rect correct_rect(const Rect& rect, const cv::Mat& image);
 
+        bool stop_requested() const { return m_stop_predicate && m_stop_predicate(); }
+
+        // m_image 的颜色转换缓存，没有设置过或者不匹配时新建一个。创建子分析器时可以传给它
+        const std::shared_ptr<ImageContext>& image_context() const;
+
+        // key 需要包含所有影响识别结果的参数，roi 需要包含识别时读取的所有像素
+        template <typename ResultT>
+        std::optional<ResultT> load_cached(const std::string& key, const Rect& roi) const
+        {
+            if (!m_frame) {
+                return std::nullopt;
+            }
+            auto cached = m_frame.tracker->load(key, roi, m_image.size(), m_frame.seq);
+            if (!cached) {
+                return std::nullopt;
+            }
+            if (const auto* result = std::any_cast<ResultT>(&*cached)) {
+                return *result;
+            }
+            return std::nullopt;
+        }
+        template <typename ResultT>
+        void store_cached(const std::string& key, const Rect& roi, ResultT result) const
+        {
+            if (!m_frame) {
+                return;
+            }
+            m_frame.tracker->store(key, roi, m_image.size(), m_frame.seq, std::move(result));
+        }
+
         cv::Mat m_image;
 #ifdef ASST_DEBUG
         cv::Mat m_image_draw;
 #endif
         Rect m_roi;
         bool m_log_tracing = true;
+        TileChangeTracker::FrameRef m_frame;
+        std::function<bool()> m_stop_predicate;
 
     private:
         using InstHelper::ctrler;
         using InstHelper::need_exit;
+
+        mutable std::shared_ptr<ImageContext> m_image_context = nullptr;
     };
 
     template <typename RectTy>
@@ -111,28 +155,60 @@ namespace asst
     }
 
     // Non-Maximum Suppression
+    // 保留下来的框按网格分桶，每个框只和同一批格子里的框比较，不用两两都算交集
     template <typename ResultsVec>
     inline static ResultsVec NMS(ResultsVec results, double threshold = 0.7)
     {
         ranges::sort(results, [](const auto& a, const auto& b) { return a.score > b.score; });
 
+        // 格子不小于最大的框，每个框最多落在 2x2 个格子里
+        int cell_size = 1;
+        for (const auto& box : results) {
+            cell_size = (std::max)({ cell_size, box.rect.width, box.rect.height });
+        }
+        auto cell_of = [cell_size](int v) { return v >= 0 ? v / cell_size : (v + 1) / cell_size - 1; };
+        auto cell_key = [](int cx, int cy) {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+        };
+        std::unordered_map<uint64_t, std::vector<size_t>> grid; // 格子 -> nms_results 中的下标
+
         ResultsVec nms_results;
-        for (size_t i = 0; i < results.size(); ++i) {
-            const auto& box = results[i];
+        for (const auto& box : results) {
             if (box.score < 0.1f) {
                 continue;
             }
-            nms_results.emplace_back(box);
-            for (size_t j = i + 1; j < results.size(); ++j) {
-                auto& box2 = results[j];
-                if (box2.score < 0.1f) {
-                    continue;
+            const cv::Rect rect = make_rect<cv::Rect>(box.rect);
+            const int left = cell_of(rect.x);
+            const int right = cell_of(rect.x + rect.width - 1);
+            const int top = cell_of(rect.y);
+            const int bottom = cell_of(rect.y + rect.height - 1);
+
+            bool suppressed = false;
+            for (int cy = top; cy <= bottom && !suppressed; ++cy) {
+                for (int cx = left; cx <= right && !suppressed; ++cx) {
+                    auto cell = grid.find(cell_key(cx, cy));
+                    if (cell == grid.end()) {
+                        continue;
+                    }
+                    for (size_t i : cell->second) {
+                        int iou_area = (make_rect<cv::Rect>(nms_results[i].rect) & rect).area();
+                        if (iou_area > threshold * box.rect.area()) {
+                            suppressed = true;
+                            break;
+                        }
+                    }
                 }
-                int iou_area = (make_rect<cv::Rect>(box.rect) & make_rect<cv::Rect>(box2.rect)).area();
-                if (iou_area > threshold * box2.rect.area()) {
-                    box2.score = 0;
+            }
+            if (suppressed) {
+                continue;
+            }
+
+            for (int cy = top; cy <= bottom; ++cy) {
+                for (int cx = left; cx <= right; ++cx) {
+                    grid[cell_key(cx, cy)].emplace_back(nms_results.size());
                 }
             }
+            nms_results.emplace_back(box);
         }
         return nms_results;
     }
@@ -2774,6 +2774,26 @@ namespace MaaWpfGui.Main
         /// 用GPU进行OCR
         /// </summary>
         GpuOCR,
+
+        /// <summary>
+        /// 识别用的线程数，0 为自动
+        /// </summary>
+        ComputeThreads,
+
+        /// <summary>
+        /// ONNX Runtime 的 intra-op 线程数，0 为跟随 ComputeThreads
+        /// </summary>
+        OnnxIntraOpThreads,
+
+        /// <summary>
+        /// ONNX Runtime 的 inter-op 线程数，0 为按顺序执行
+        /// </summary>
+        OnnxInterOpThreads,
+
+        /// <summary>
+        /// ONNX Runtime 是否使用 CPU 内存池
+        /// </summary>
+        OnnxMemoryArena,
     }
 
     public enum InstanceOptionKey